@@ -134,6 +134,11 @@ public:
   const ExprHashMap<Path::PathIndex> &indexes() const;
   const ordered_constraints_ty &orderedCS() const;
 
+  /// Incremented whenever the constraints change in a way that can turn a
+  /// previously valid expression invalid (i.e. when symcretes or their
+  /// concretization change). Adding constraints keeps the epoch.
+  std::uint64_t epoch() const;
+
   static PathConstraints concat(const PathConstraints &l,
                                 const PathConstraints &r);
 
@@ -144,6 +149,7 @@ private:
   ExprHashMap<Path::PathIndex> pathIndexes;
   ordered_constraints_ty orderedConstraints;
   ExprHashMap<ExprHashSet> _simplificationMap;
+  std::uint64_t _epoch = 0;
 };
 
 struct Conflict {
@@ -619,12 +619,25 @@ private:
   /// size of this update sequence, including this update
   unsigned size;
 
+  /// Skip pointer past the run of writes at constant indices that starts at
+  /// this update: the first older update with a symbolic index, or null if
+  /// there is none. Points to this update if its own index is symbolic.
+  UpdateNode *runEnd;
+  /// Bounds of the constant indices written in that run.
+  uint64_t runMin, runMax;
+
 public:
   UpdateNode(const ref<UpdateNode> &_next, const ref<Expr> &_index,
              const ref<Expr> &_value);
 
   unsigned getSize() const { return size; }
 
+  UpdateNode *getRunEnd() const { return runEnd; }
+  /// False if no update in the run starting here writes at `index`.
+  bool runMayWrite(uint64_t index) const {
+    return runEnd == this || (runMin <= index && index <= runMax);
+  }
+
   int compare(const UpdateNode &b) const;
   bool equals(const UpdateNode &b) const;
   unsigned hash() const { return hashValue; }
@@ -727,6 +740,12 @@ public:
 
   void extend(const ref<Expr> &index, const ref<Expr> &value);
 
+  /// Fold all updates into a new constant root array, keeping only the most
+  /// recent write of a symbolic value to each index as an update. Possible
+  /// only if the root is constant and every update has a constant index.
+  /// Returns true if the list was compacted.
+  bool compact();
+
   int compare(const UpdateList &b) const;
 
   bool operator<(const UpdateList &rhs) const { return compare(rhs) < 0; }
@@ -1542,19 +1561,15 @@ public:
   static ref<Expr> fromMemory(void *address, Width w);
   void toMemory(void *address);
 
-  static ref<ConstantExpr> alloc(const llvm::APInt &v) {
-    auto success = cachedConstantExpressions.cache.find(v);
-    if (success == cachedConstantExpressions.cache.end()) {
-      // Cache miss
-      ref<ConstantExpr> r = new ConstantExpr(v);
-      r->computeHash();
-      r->computeHeight();
-      r->isCached = true;
-      cachedConstantExpressions.cache[v] = r.get();
-      return r;
-    }
-    return success->second;
-  }
+  /// Returns the preallocated constant for (v, w) if it lies in the small
+  /// constant table, and null otherwise. No hashing is involved.
+  static ConstantExpr *getSmallConstant(uint64_t v, Width w);
+
+  /// Number of constants currently held by the intern table (not counting
+  /// the small constant table).
+  static std::size_t getNumCachedConstants();
+
+  static ref<ConstantExpr> alloc(const llvm::APInt &v);
 
   static ref<ConstantExpr> alloc(const llvm::APFloat &f) {
     ref<ConstantExpr> r(new ConstantExpr(f.bitcastToAPInt(), true));
@@ -1564,6 +1579,8 @@ public:
   }
 
   static ref<ConstantExpr> alloc(uint64_t v, Width w) {
+    if (ConstantExpr *small = getSmallConstant(v, w))
+      return small;
     return alloc(llvm::APInt(w, v));
   }
 
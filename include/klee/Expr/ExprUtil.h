@@ -16,6 +16,7 @@
 
 #include <set>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace klee {
@@ -54,6 +55,12 @@ bool isReadFromSymbolicArray(ref<Expr> e);
 
 ref<Expr> createNonOverflowingSumExpr(const std::vector<ref<Expr>> &terms);
 
+/// Computes an interval [min, max] containing all unsigned values `e` can
+/// take, looking only at the structure of the expression. Widths above 64
+/// bits and unsupported expressions yield the full range. Shared
+/// subexpressions are visited once, so this is linear in the size of the DAG.
+std::pair<uint64_t, uint64_t> getValueBounds(const ref<Expr> &e);
+
 class ConstantArrayFinder : public ExprVisitor {
 protected:
   ExprVisitor::Action visitRead(const ReadExpr &re);
@@ -12,13 +12,56 @@
 
 #include "klee/Expr/Expr.h"
 
+#include <cassert>
+#include <cstdint>
+
 namespace klee {
 class MemoryObject;
 
+/// A register value. Concrete integers of up to 64 bits can be stored
+/// unboxed, so that concrete arithmetic does not go through the constant
+/// expression cache. They are only materialized as a ConstantExpr when an
+/// expression is requested.
 struct Cell {
-  ref<Expr> value;
+private:
+  mutable ref<Expr> expr;
+  std::uint64_t bits = 0;
+  Expr::Width width = Expr::InvalidWidth;
+
+public:
   Cell() = default;
-  explicit Cell(ref<Expr> value) : value(value) {}
+  explicit Cell(ref<Expr> value) : expr(std::move(value)) {}
+  Cell(std::uint64_t bits, Expr::Width width) : bits(bits), width(width) {
+    assert(width != Expr::InvalidWidth && width <= Expr::Int64 &&
+           bits == bits64::truncateToNBits(bits, width) && "invalid constant");
+  }
+
+  bool isNull() const { return expr.isNull() && width == Expr::InvalidWidth; }
+
+  /// Returns the value as an expression (null for an unset register).
+  const ref<Expr> &value() const {
+    if (expr.isNull() && width != Expr::InvalidWidth)
+      expr = ConstantExpr::create(bits, width);
+    return expr;
+  }
+
+  /// Returns true and sets \p v and \p w if the value is a concrete integer
+  /// of at most 64 bits.
+  bool getConcrete(std::uint64_t &v, Expr::Width &w) const {
+    if (width != Expr::InvalidWidth) {
+      v = bits;
+      w = width;
+      return true;
+    }
+    if (auto ce = dyn_cast_or_null<ConstantExpr>(expr)) {
+      if (ce->getWidth() <= Expr::Int64) {
+        v = ce->getZExtValue();
+        w = ce->getWidth();
+        return true;
+      }
+    }
+    return false;
+  }
 };
 } // namespace klee
 
@@ -50,6 +50,9 @@ private:
   functionBranchesSet functionConditionalBranches;
   functionBranchesSet functionBlocks;
 
+  std::unordered_map<KFunction *, std::unordered_map<KBlock *, KBlock *>>
+      functionPostDominators;
+
 private:
   void calculateDistance(KBlock *bb);
   void calculateBackwardDistance(KBlock *bb);
@@ -60,6 +63,7 @@ private:
   void calculateFunctionBranches(KFunction *kf);
   void calculateFunctionConditionalBranches(KFunction *kf);
   void calculateFunctionBlocks(KFunction *kf);
+  void calculatePostDominators(KFunction *kf);
 
 public:
   const BlockDistanceMap &getDistance(KBlock *b);
@@ -77,6 +81,10 @@ public:
   const KBlockMap<std::set<unsigned>> &
   getFunctionConditionalBranches(KFunction *kf);
   const KBlockMap<std::set<unsigned>> &getFunctionBlocks(KFunction *kf);
+
+  /// Returns the immediate post-dominator of the given block, or nullptr if
+  /// the block is only post-dominated by the function exit.
+  KBlock *getImmediatePostDominator(KBlock *kb);
 };
 
 } // namespace klee
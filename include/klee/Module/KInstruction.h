@@ -68,6 +68,29 @@ struct KInstruction : public KValue {
     }
   };
 
+  /// Operations the interpreter evaluates directly when all operands are
+  /// concrete values of at most 64 bits. Decoded once from the LLVM
+  /// instruction so that dispatch needs no type or predicate inspection.
+  enum class ConcreteOp : uint8_t {
+    None,
+    Add,
+    Sub,
+    Mul,
+    And,
+    Or,
+    Xor,
+    ICmpEQ,
+    ICmpNE,
+    ICmpUGT,
+    ICmpUGE,
+    ICmpULT,
+    ICmpULE,
+    ICmpSGT,
+    ICmpSGE,
+    ICmpSLT,
+    ICmpSLE,
+  };
+
   llvm::Instruction *inst() const {
     return llvm::dyn_cast_or_null<llvm::Instruction>(value);
   }
@@ -75,15 +98,38 @@ struct KInstruction : public KValue {
   /// Value numbers for each operand. -1 is an invalid value,
   /// otherwise negative numbers are indices (negated and offset by
   /// 2) into the module constant table and positive numbers are
-  /// register indices.
-  int *operands;
+  /// register indices. Points into the operand table of the parent
+  /// function, which stores the operands of all its instructions
+  /// contiguously.
+  int *operands = nullptr;
   KBlock *parent;
 
 private:
   // Instruction index in the basic block
   const unsigned globalIndex;
+  // LLVM opcode, cached for dispatch in the interpreter loop
+  const unsigned opcode;
+  const ConcreteOp concreteOp;
 
 public:
+  /// Number of operand slots `setOperands` fills for the instruction:
+  /// the called value followed by the arguments for calls, all LLVM
+  /// operands otherwise.
+  static unsigned getNumOperandSlots(const llvm::Instruction &inst);
+
+  /// Compute the value numbers of the operands into `slots`, which must
+  /// have room for `getNumOperandSlots(*inst())` entries, and make
+  /// `operands` point to them.
+  void setOperands(int *slots,
+                   const std::unordered_map<llvm::Instruction *, unsigned>
+                       &instructionToRegisterMap,
+                   KModule *km);
+
+  /// LLVM opcode of the instruction.
+  [[nodiscard]] unsigned getOpcode() const { return opcode; }
+  /// Concrete fast path of the instruction, ConcreteOp::None if it has none.
+  [[nodiscard]] ConcreteOp getConcreteOp() const { return concreteOp; }
+
   /// Unique index for KFunction and KInstruction inside KModule
   /// from 0 to [KFunction + KInstruction]
   [[nodiscard]] unsigned getGlobalIndex() const;
@@ -92,14 +138,12 @@ public:
   /// Destination register index.
   [[nodiscard]] unsigned getDest() const;
 
-  KInstruction(const std::unordered_map<llvm::Instruction *, unsigned>
-                   &_instructionToRegisterMap,
-               llvm::Instruction *_inst, KModule *_km, KBlock *_kb,
+  KInstruction(llvm::Instruction *_inst, KBlock *_kb,
                unsigned &_globalIndexInc);
 
   KInstruction() = delete;
   explicit KInstruction(const KInstruction &ki) = delete;
-  virtual ~KInstruction();
+  virtual ~KInstruction() = default;
   std::string getSourceLocation() const;
 
   [[nodiscard]] size_t getLine() const;
@@ -110,7 +154,7 @@ public:
   [[nodiscard]] std::string getSourceLocationString() const;
   [[nodiscard]] std::string toString() const;
   bool operator==(const KInstruction &other) const {
-    return getID() == other.getID();
+    return globalIndex == other.globalIndex;
   }
 
   [[nodiscard]] inline KBlock *getKBlock() const { return parent; }
@@ -120,7 +164,7 @@ public:
 
   [[nodiscard]] bool operator<(const KValue &rhs) const override {
     if (getKind() == rhs.getKind()) {
-      return getID() < cast<KInstruction>(rhs).getID();
+      return globalIndex < cast<KInstruction>(rhs).globalIndex;
     } else {
       return getKind() < rhs.getKind();
     }
@@ -130,7 +174,9 @@ public:
     return getKFunction()->parent;
   }
 
-  [[nodiscard]] unsigned hash() const override { return getID().hash(); }
+  /// Global indices are unique in the module, so they order and hash
+  /// instructions the same way as the full index triple
+  [[nodiscard]] unsigned hash() const override { return globalIndex; }
 
   static bool classof(const KValue *rhs) {
     return rhs->getKind() == Kind::INSTRUCTION;
@@ -149,19 +195,16 @@ struct KGEPInstruction : KInstruction {
   uint64_t offset;
 
 public:
-  KGEPInstruction(const std::unordered_map<llvm::Instruction *, unsigned>
-                      &_instructionToRegisterMap,
-                  llvm::Instruction *_inst, KModule *_km, KBlock *_kb,
+  KGEPInstruction(llvm::Instruction *_inst, KBlock *_kb,
                   unsigned &_globalIndexInc)
-      : KInstruction(_instructionToRegisterMap, _inst, _km, _kb,
-                     _globalIndexInc) {}
+      : KInstruction(_inst, _kb, _globalIndexInc) {}
   KGEPInstruction() = delete;
   explicit KGEPInstruction(const KGEPInstruction &ki) = delete;
 };
 
 struct KInstructionCompare {
   bool operator()(const KInstruction *a, const KInstruction *b) const {
-    return a->getID() < b->getID();
+    return a->getGlobalIndex() < b->getGlobalIndex();
   }
 };
 } // namespace klee
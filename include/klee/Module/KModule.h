@@ -12,6 +12,7 @@
 
 #include "klee/Config/Version.h"
 #include "klee/Core/Interpreter.h"
+#include "klee/Module/Cell.h"
 #include "klee/Module/KCallable.h"
 #include "klee/Module/KValue.h"
 
@@ -24,6 +25,7 @@ DISABLE_WARNING_DEPRECATED_DECLARATIONS
 DISABLE_WARNING_POP
 
 #include <deque>
+#include <functional>
 #include <map>
 #include <memory>
 #include <set>
@@ -34,12 +36,15 @@ DISABLE_WARNING_POP
 
 namespace llvm {
 class BasicBlock;
+class CallBase;
 class Constant;
 class Function;
 class Value;
 class Instruction;
 class Module;
 class DataLayout;
+class LLVMContext;
+class StringRef;
 
 /// Compute the true target of a function call, resolving LLVM aliases
 /// and bitcasts.
@@ -47,7 +52,6 @@ Function *getTargetFunction(Value *calledVal);
 } // namespace llvm
 
 namespace klee {
-struct Cell;
 class Executor;
 class Expr;
 class InterpreterHandler;
@@ -89,9 +93,8 @@ private:
   const KBlockType blockKind;
 
 protected:
-  KBlock(KFunction *, llvm::BasicBlock *, KModule *,
-         const std::unordered_map<llvm::Instruction *, unsigned> &,
-         KInstruction **, unsigned &globalIndexInc, KBlockType blockType);
+  KBlock(KFunction *, llvm::BasicBlock *, KInstruction **,
+         unsigned &globalIndexInc, KBlockType blockType);
   KBlock(const KBlock &) = delete;
   KBlock &operator=(const KBlock &) = delete;
 
@@ -131,9 +134,8 @@ typedef std::function<bool(KBlock *)> KBlockPredicate;
 
 struct KBasicBlock : public KBlock {
 public:
-  KBasicBlock(KFunction *, llvm::BasicBlock *, KModule *,
-              const std::unordered_map<llvm::Instruction *, unsigned> &,
-              KInstruction **, unsigned &globalIndexInc);
+  KBasicBlock(KFunction *, llvm::BasicBlock *, KInstruction **,
+              unsigned &globalIndexInc);
 
   ///  For LLVM RTTI purposes in KBlock inheritance system
   static bool classof(const KBlock *rhs) {
@@ -151,9 +153,8 @@ struct KCallBlock : KBlock {
   KFunctionSet calledFunctions;
 
 public:
-  KCallBlock(KFunction *, llvm::BasicBlock *, KModule *,
-             const std::unordered_map<llvm::Instruction *, unsigned> &,
-             KInstruction **, unsigned &globalIndexInc);
+  KCallBlock(KFunction *, llvm::BasicBlock *, KInstruction **,
+             unsigned &globalIndexInc);
   static bool classof(const KCallBlock *) { return true; }
   static bool classof(const KBlock *E) {
     return E->getKBlockType() == KBlockType::Call;
@@ -170,9 +171,8 @@ public:
 
 struct KReturnBlock : KBlock {
 public:
-  KReturnBlock(KFunction *, llvm::BasicBlock *, KModule *,
-               const std::unordered_map<llvm::Instruction *, unsigned> &,
-               KInstruction **, unsigned &globalIndexInc);
+  KReturnBlock(KFunction *, llvm::BasicBlock *, KInstruction **,
+               unsigned &globalIndexInc);
   static bool classof(const KReturnBlock *) { return true; }
   static bool classof(const KBlock *E) {
     return E->getKBlockType() == KBlockType::Return;
@@ -188,9 +188,23 @@ private:
   std::unordered_map<std::string, KBlock *> labelMap;
   const unsigned globalIndex;
 
+  /// Blocks and instructions are only built on first use, see materialize()
+  mutable bool materialized = false;
+  mutable KInstruction **instructions = nullptr;
+  /// Operand value numbers of all instructions, see KInstruction::operands
+  mutable std::unique_ptr<int[]> operandTable;
+  mutable std::unordered_map<const llvm::Instruction *, KInstruction *>
+      instructionMap;
+  mutable std::vector<std::unique_ptr<KBlock>> blocks;
+  mutable std::unordered_map<const llvm::BasicBlock *, KBlock *> blockMap;
+  mutable KBlock *entryKBlock = nullptr;
+  mutable std::vector<KBlock *> returnKBlocks;
+  mutable std::vector<KCallBlock *> kCallBlocks;
+
+  void build() const;
+
 public:
   KModule *parent;
-  KInstruction **instructions;
 
   [[nodiscard]] llvm::Function *function() const {
     return llvm::dyn_cast_or_null<llvm::Function>(value);
@@ -198,12 +212,47 @@ public:
 
   [[nodiscard]] KInstruction *getInstructionByRegister(size_t reg) const;
 
-  std::unordered_map<const llvm::Instruction *, KInstruction *> instructionMap;
-  std::vector<std::unique_ptr<KBlock>> blocks;
-  std::unordered_map<const llvm::BasicBlock *, KBlock *> blockMap;
-  KBlock *entryKBlock;
-  std::vector<KBlock *> returnKBlocks;
-  std::vector<KCallBlock *> kCallBlocks;
+  /// Build the blocks and instructions of this function unless they
+  /// already exist. Global indices are reserved when the function is
+  /// created, so they do not depend on the order of materialization.
+  void materialize() const {
+    if (!materialized)
+      build();
+  }
+  [[nodiscard]] bool isMaterialized() const { return materialized; }
+
+  [[nodiscard]] KInstruction **getInstructions() const {
+    materialize();
+    return instructions;
+  }
+  [[nodiscard]] const std::unordered_map<const llvm::Instruction *,
+                                         KInstruction *> &
+  getInstructionMap() const {
+    materialize();
+    return instructionMap;
+  }
+  [[nodiscard]] const std::vector<std::unique_ptr<KBlock>> &
+  getBlocks() const {
+    materialize();
+    return blocks;
+  }
+  [[nodiscard]] const std::unordered_map<const llvm::BasicBlock *, KBlock *> &
+  getBlockMap() const {
+    materialize();
+    return blockMap;
+  }
+  [[nodiscard]] KBlock *getEntryKBlock() const {
+    materialize();
+    return entryKBlock;
+  }
+  [[nodiscard]] const std::vector<KBlock *> &getReturnKBlocks() const {
+    materialize();
+    return returnKBlocks;
+  }
+  [[nodiscard]] const std::vector<KCallBlock *> &getKCallBlocks() const {
+    materialize();
+    return kCallBlocks;
+  }
 
   /// count of instructions in function
   unsigned numInstructions;
@@ -227,7 +276,7 @@ public:
 
   const std::unordered_map<std::string, KBlock *> &getLabelMap() {
     if (labelMap.size() == 0) {
-      for (auto &kb : blocks) {
+      for (auto &kb : getBlocks()) {
         labelMap[kb->getLabel()] = kb.get();
       }
     }
@@ -247,6 +296,13 @@ public:
   /// Unique index for KFunction and KInstruction inside KModule
   /// from 0 to [KFunction + KInstruction]
   [[nodiscard]] inline unsigned getGlobalIndex() const { return globalIndex; }
+
+  /// Global index of the instruction at the given position of the function
+  /// body, which is known without building the function
+  [[nodiscard]] inline unsigned
+  getInstructionGlobalIndex(unsigned position) const {
+    return globalIndex + 1 + position;
+  }
 };
 
 struct KConstant : public KValue {
@@ -301,6 +357,11 @@ class KModule {
 private:
   bool withPosixRuntime; // TODO move to opts
   unsigned maxGlobalIndex;
+  Interpreter::GuidanceKind guidance;
+
+  friend struct KFunction;
+  // Resolve the targets of the calls in a freshly built function
+  void addCallBlocks(KFunction *kf);
 
 public:
   std::unique_ptr<llvm::Module> module;
@@ -317,6 +378,17 @@ public:
   // XXX change to KFunction
   KFunctionSet escapingFunctions;
 
+  /// Add to `targets` the escaping functions that may be called by the
+  /// indirect call `cb`. Unless disabled, only functions whose signature
+  /// is compatible with the call site are added; if none is, all escaping
+  /// functions are.
+  void getIndirectCallTargets(const llvm::CallBase &cb,
+                              KFunctionSet &targets) const;
+
+  /// Defined functions whose structure is the same as in the run given
+  /// by --changed-since. Their instructions count as covered.
+  KFunctionSet unchangedFunctions;
+
   std::set<std::string> mainModuleFunctions;
   std::set<std::string> mainModuleGlobals;
 
@@ -331,16 +403,25 @@ public:
                      std::unique_ptr<KGlobalVariable>>
       globalMap;
 
-  std::unique_ptr<Cell[]> constantTable;
+  // Evaluated constants, indexed by constant ID. A deque keeps references
+  // stable while functions built later append their constants.
+  std::deque<Cell> constantTable;
+
+  // Invoked for every function built after manifest(), e.g. to evaluate
+  // the constants it introduced
+  std::function<void(KFunction *)> onMaterialize;
 
   // Functions which are part of KLEE runtime
   std::set<const llvm::Function *> internalFunctions;
 
-  // instruction to assembly.ll line empty if no statistic enabled
-  std::unordered_map<uintptr_t, uint64_t> asmLineMap;
+  // assembly.ll line of each function and instruction, indexed by global
+  // index; empty if assembly.ll is not written
+  std::vector<uint32_t> asmLines;
 
   // Mark function with functionName as part of the KLEE runtime
   void addInternalFunction(const char *functionName);
+  // Mark the check functions requested in opts as part of the KLEE runtime
+  void addInternalCheckFunctions(const Interpreter::ModuleOptions &opts);
   // Replace std functions with KLEE intrinsics
   void replaceFunction(const std::unique_ptr<llvm::Module> &m,
                        const char *original, const char *replacement);
@@ -378,6 +459,26 @@ public:
 
   void instrument(const Interpreter::ModuleOptions &opts);
 
+  /// Compute a key identifying the module that linking, instrumenting and
+  /// preparing the given inputs produces under the current options.
+  ///
+  /// @param modules the modules that will be linked together
+  /// @param extra further inputs, e.g. contents of runtime libraries
+  static std::string
+  getPreparedModuleKey(llvm::ArrayRef<const llvm::Module *> modules,
+                       llvm::ArrayRef<llvm::StringRef> extra,
+                       const Interpreter::ModuleOptions &opts);
+
+  /// Load a module stored by storePreparedModule() instead of linking and
+  /// preparing the inputs again.
+  ///
+  /// @return false if no prepared module could be loaded from path
+  bool loadPreparedModule(const std::string &path, llvm::LLVMContext &ctx,
+                          const Interpreter::ModuleOptions &opts);
+
+  /// Store the module returned by optimiseAndPrepare() at path.
+  void storePreparedModule(const std::string &path) const;
+
   /// Return an id for the given constant, creating a new one if necessary.
   unsigned getConstantID(llvm::Constant *c, KInstruction *ki);
 
@@ -387,6 +488,9 @@ public:
 
   KBlock *getKBlock(const llvm::BasicBlock *bb);
 
+  /// Build every function, for analyses that need the whole program.
+  void materializeAll();
+
   bool inMainModule(const llvm::Instruction &i);
 
   bool inMainModule(const llvm::Function &f);
@@ -395,9 +499,9 @@ public:
 
   bool WithPOSIXRuntime() { return withPosixRuntime; }
 
-  std::optional<size_t> getAsmLine(const uintptr_t ref) const;
+  std::optional<size_t> getAsmLine(unsigned globalIndex) const;
   std::optional<size_t> getAsmLine(const llvm::Function *func) const;
-  std::optional<size_t> getAsmLine(const llvm::Instruction *inst) const;
+  std::optional<size_t> getAsmLine(const KInstruction *ki) const;
 
   inline unsigned getMaxGlobalIndex() const { return maxGlobalIndex; }
   unsigned getGlobalIndex(const llvm::Function *func) const;
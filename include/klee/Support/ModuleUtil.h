@@ -83,6 +83,16 @@ llvm::Function *getDirectCallTarget(const llvm::CallBase &cb,
 /// terminates in a direct call).
 bool functionEscapes(const llvm::Function *f);
 
+/// Return true iff the signature of `f` is compatible with the call site
+/// `cb`, i.e. `f` may be the target of `cb` when it is an indirect call.
+///
+/// The check is deliberately permissive: pointer types match each other,
+/// integers match integers of the same width, a call that ignores the
+/// return value matches any return type and variadic functions accept any
+/// surplus arguments.
+bool isCompatibleIndirectCallTarget(const llvm::CallBase &cb,
+                                    const llvm::Function &f);
+
 /// Loads the file libraryName and reads all possible modules out of it.
 ///
 /// Different file types are possible:
@@ -13,12 +13,18 @@
 #include "Memory.h"
 #include "TimingSolver.h"
 
+#include "klee/Core/Context.h"
 #include "klee/Expr/Expr.h"
+#include "klee/Expr/ExprUtil.h"
 #include "klee/Module/KType.h"
 #include "klee/Statistics/TimerStatIncrementer.h"
 
 #include "CoreStats.h"
 
+#include <cstring>
+#include <set>
+#include <tuple>
+
 namespace klee {
 llvm::cl::OptionCategory
     PointerResolvingCat("Pointer resolving options",
@@ -242,26 +248,28 @@ bool AddressSpace::resolveOne(ExecutionState &state, TimingSolver *solver,
 
   // didn't work, now we have to search
 
-  for (MemoryMap::iterator oi = objects.begin(), oe = objects.end(); oi != oe;
-       ++oi) {
-    const auto &mo = oi->first;
-    if (!predicate(mo, oi->second.get())) {
-      continue;
-    }
+  for (const auto &range : getCandidateObjects(address->getBase())) {
+    for (MemoryMap::iterator oi = range.first; oi != range.second; ++oi) {
+      const auto &mo = oi->first;
+      if (!predicate(mo, oi->second.get())) {
+        continue;
+      }
 
-    if (haltExecution) {
-      break;
-    }
+      if (haltExecution) {
+        success = false;
+        return true;
+      }
 
-    bool mayBeTrue;
-    if (!solver->mayBeTrue(state.constraints.cs(),
-                           mo->getBoundsCheckPointer(address), mayBeTrue,
-                           state.queryMetaData))
-      return false;
-    if (mayBeTrue) {
-      result = {oi->first, oi->second.get()};
-      success = true;
-      return true;
+      bool mayBeTrue;
+      if (!solver->mayBeTrue(state.constraints.cs(),
+                             mo->getBoundsCheckPointer(address), mayBeTrue,
+                             state.queryMetaData))
+        return false;
+      if (mayBeTrue) {
+        result = {oi->first, oi->second.get()};
+        success = true;
+        return true;
+      }
     }
   }
 
@@ -344,26 +352,40 @@ bool AddressSpace::resolve(ExecutionState &state, TimingSolver *solver,
   // to hit the fast path with exactly 2 queries). we could also
   // just get this by inspection of the expr.
 
-  for (MemoryMap::iterator oi = objects.begin(), oe = objects.end(); oi != oe;
-       ++oi) {
-    const MemoryObject *mo = oi->first;
-    if (!predicate(mo, oi->second.get())) {
-      continue;
-    }
+  for (const auto &range : getCandidateObjects(p->getBase())) {
+    for (MemoryMap::iterator oi = range.first; oi != range.second; ++oi) {
+      const MemoryObject *mo = oi->first;
+      if (!predicate(mo, oi->second.get())) {
+        continue;
+      }
 
-    if (timeout && timeout < timer.delta())
-      return true;
+      if (timeout && timeout < timer.delta())
+        return true;
 
-    auto op = std::make_pair<>(mo, oi->second.get());
+      auto op = std::make_pair<>(mo, oi->second.get());
 
-    int incomplete =
-        checkPointerInObject(state, solver, p, op, rl, maxResolutions);
-    if (incomplete != 2)
-      return incomplete ? true : false;
+      int incomplete =
+          checkPointerInObject(state, solver, p, op, rl, maxResolutions);
+      if (incomplete != 2)
+        return incomplete ? true : false;
+    }
   }
   return false;
 }
 
+std::array<AddressSpace::ObjectRange, 2>
+AddressSpace::getCandidateObjects(ref<Expr> base) const {
+  uint64_t min, max;
+  std::tie(min, max) = getValueBounds(base);
+
+  MemoryObject lowest(min), highest(max), last(UINT64_MAX);
+  MemoryMap::iterator symbolicAddresses = objects.upper_bound(&last);
+  return {ObjectRange(objects.lower_bound(&lowest),
+                      max == UINT64_MAX ? symbolicAddresses
+                                        : objects.upper_bound(&highest)),
+          ObjectRange(symbolicAddresses, objects.end())};
+}
+
 // These two are pretty big hack so we can sort of pass memory back
 // and forth to externals. They work by abusing the concrete cache
 // store inside of the object states, which allows them to
@@ -403,6 +425,11 @@ void AddressSpace::copyOutConcrete(const MemoryObject *mo,
     if (ref<ConstantExpr> sizeExpr =
             dyn_cast<ConstantExpr>(mo->getSizeExpr())) {
       size_t moSize = sizeExpr->getZExtValue();
+      llvm::StringRef pending = os->getPendingContents();
+      if (pending.size() == moSize) {
+        std::memcpy(address, pending.data(), moSize);
+        return;
+      }
       std::vector<uint8_t> concreteStore(moSize);
       for (size_t i = 0; i < moSize; i++) {
         auto byte = evaluator.visit(os->readValue8(i));
@@ -439,6 +466,11 @@ bool AddressSpace::copyInConcrete(const MemoryObject *mo, const ObjectState *os,
   auto address = reinterpret_cast<std::uint8_t *>(src_address);
   size_t moSize =
       cast<ConstantExpr>(evaluator.visit(mo->getSizeExpr()))->getZExtValue();
+  llvm::StringRef pending = os->getPendingContents();
+  if (pending.size() == moSize &&
+      memcmp(address, pending.data(), moSize) == 0) {
+    return true;
+  }
   std::vector<uint8_t> concreteStore(moSize);
   for (size_t i = 0; i < moSize; i++) {
     auto byte = evaluator.visit(os->readValue8(i));
@@ -457,6 +489,65 @@ bool AddressSpace::copyInConcrete(const MemoryObject *mo, const ObjectState *os,
   return true;
 }
 
+void AddressSpace::copyOutReachableConcretes(
+    const std::vector<uint64_t> &roots, const Assignment &assignment,
+    std::vector<const MemoryObject *> &copied) {
+  std::set<const MemoryObject *> visited;
+  std::vector<uint64_t> worklist(roots);
+
+  for (const auto &object : objects) {
+    if (object.first->isFixed)
+      worklist.push_back(*object.first->address);
+  }
+
+  const unsigned pointerBytes = Context::get().getPointerWidth() / CHAR_BIT;
+  while (!worklist.empty()) {
+    uint64_t address = worklist.back();
+    worklist.pop_back();
+
+    ObjectPair op;
+    if (address == 0 ||
+        !resolveOne(ConstantPointerExpr::create(Expr::createPointer(address),
+                                                Expr::createPointer(address)),
+                    nullptr, op) ||
+        !visited.insert(op.first).second) {
+      continue;
+    }
+
+    const MemoryObject *mo = op.first;
+    const ObjectState *os = op.second;
+    ref<ConstantExpr> sizeExpr = dyn_cast<ConstantExpr>(mo->getSizeExpr());
+    if (!sizeExpr || mo->isUserSpecified || sizeExpr->getZExtValue() == 0)
+      continue;
+
+    // Read-only objects were copied out when they were initialized
+    if (!os->readOnly)
+      copyOutConcrete(mo, os, assignment);
+    copied.push_back(mo);
+
+    // Every aligned pointer-sized word may point to another object
+    auto base = reinterpret_cast<const std::uint8_t *>(*mo->address);
+    uint64_t size = sizeExpr->getZExtValue();
+    for (uint64_t offset = 0; offset + pointerBytes <= size;
+         offset += pointerBytes) {
+      uint64_t word = 0;
+      std::memcpy(&word, base + offset, pointerBytes);
+      worklist.push_back(word);
+    }
+  }
+}
+
+bool AddressSpace::copyInConcretes(
+    const std::vector<const MemoryObject *> &copied,
+    const Assignment &assignment) {
+  for (const MemoryObject *mo : copied) {
+    const ObjectState *os = findObject(mo).second;
+    if (!copyInConcrete(mo, os, *mo->address, assignment))
+      return false;
+  }
+  return true;
+}
+
 /***/
 
 bool MemoryObjectLT::operator()(const MemoryObject *a,
@@ -17,6 +17,8 @@
 #include "klee/Expr/Expr.h"
 #include "klee/System/Time.h"
 
+#include <array>
+
 namespace klee {
 class ExecutionState;
 class MemoryObject;
@@ -60,6 +62,14 @@ private:
                            ref<PointerExpr> p, const ObjectPair &op,
                            ResolutionList &rl, unsigned maxResolutions) const;
 
+  typedef std::pair<MemoryMap::iterator, MemoryMap::iterator> ObjectRange;
+
+  /// Returns the ranges of objects a pointer with the given base can point
+  /// to, in address order: the objects whose concrete address lies in an
+  /// interval of the possible values of `base` (computed without the
+  /// solver), followed by the objects with a symbolic address.
+  std::array<ObjectRange, 2> getCandidateObjects(ref<Expr> base) const;
+
 public:
   /// The MemoryObject -> ObjectState map that constitutes the
   /// address space.
@@ -170,6 +180,22 @@ public:
   /// \retval false The copy failed because a read-only object was modified.
   bool copyInConcretes(const Assignment &assignment);
 
+  /// Copy out the concrete values of the objects reachable from the given
+  /// addresses only: the objects containing one of them and, transitively,
+  /// the objects containing an aligned pointer-sized word stored in an
+  /// object already copied. Objects with a fixed address are always
+  /// included. The visited objects are appended to `copied`, to be passed to
+  /// copyInConcretes after the external call.
+  void copyOutReachableConcretes(const std::vector<uint64_t> &roots,
+                                 const Assignment &assignment,
+                                 std::vector<const MemoryObject *> &copied);
+
+  /// Copy back the concrete values of the given objects only.
+  ///
+  /// \retval false The copy failed because a read-only object was modified.
+  bool copyInConcretes(const std::vector<const MemoryObject *> &copied,
+                       const Assignment &assignment);
+
   /// Updates the memory object with the raw memory from the address
   ///
   /// @param mo The MemoryObject to update
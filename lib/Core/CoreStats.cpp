@@ -13,12 +13,14 @@
 using namespace klee;
 
 Statistic stats::allocations("Allocations", "Alloc");
+Statistic stats::copiedFrames("CopiedFrames", "CopFrames");
 Statistic stats::coveredInstructions("CoveredInstructions", "Icov");
 Statistic stats::externalCalls("ExternalCalls", "ExtC");
 Statistic stats::falseBranches("FalseBranches", "Bf");
 Statistic stats::forkTime("ForkTime", "Ftime");
 Statistic stats::forks("Forks", "Forks");
 Statistic stats::inhibitedForks("InhibitedForks", "InhibForks");
+Statistic stats::mergedStates("MergedStates", "Merges");
 Statistic stats::instructionRealTime("InstructionRealTimes", "Ireal");
 Statistic stats::instructionTime("InstructionTimes", "Itime");
 Statistic stats::instructions("Instructions", "I");
@@ -27,6 +29,7 @@ Statistic stats::minDistToUncovered("MinDistToUncovered", "UCdist");
 Statistic stats::resolveTime("ResolveTime", "Rtime");
 Statistic stats::solverTime("SolverTime", "Stime");
 Statistic stats::states("States", "States");
+Statistic stats::summarizedCalls("SummarizedCalls", "SumCalls");
 Statistic stats::trueBranches("TrueBranches", "Bt");
 Statistic stats::uncoveredInstructions("UncoveredInstructions", "Iuncov");
 
@@ -38,6 +38,17 @@ extern Statistic forks;
 /// Number of inhibited forks.
 extern Statistic inhibitedForks;
 
+/// Number of states merged into another state at a join point.
+extern Statistic mergedStates;
+
+/// Number of stack frames cloned because they were shared with another state
+/// when they were about to be modified.
+extern Statistic copiedFrames;
+
+/// Number of calls whose result was taken from an earlier call with the
+/// same concrete arguments, see --summarize-pure-calls.
+extern Statistic summarizedCalls;
+
 /// Number of states, this is a "fake" statistic used by istats, it
 /// isn't normally up-to-date.
 extern Statistic states;
@@ -148,7 +148,7 @@ bool DistanceCalculator::distanceInCallGraph(
 
   distance = UINT_MAX;
   bool cannotReachItself = strictlyAfterKB && !codeGraphInfo.hasCycle(origKB);
-  for (auto kCallBlock : kf->kCallBlocks) {
+  for (auto kCallBlock : kf->getKCallBlocks()) {
     if (!dist.count(kCallBlock) || (cannotReachItself && origKB == kCallBlock))
       continue;
     for (auto calledFunction : kCallBlock->calledFunctions) {
@@ -187,7 +187,7 @@ WeightResult DistanceCalculator::tryGetPreTargetWeight(KBlock *kb,
       codeGraphInfo.getBackwardDistance(target->parent);
   KFunction *currentKF = kb->parent;
   std::vector<KBlock *> localTargets;
-  for (auto kCallBlock : currentKF->kCallBlocks) {
+  for (auto kCallBlock : currentKF->getKCallBlocks()) {
     for (auto calledFunction : kCallBlock->calledFunctions) {
       if (distanceToTargetFunction.count(calledFunction)) {
         localTargets.push_back(kCallBlock);
@@ -207,7 +207,7 @@ WeightResult DistanceCalculator::tryGetPostTargetWeight(KBlock *kb,
                                                         weight_type &weight,
                                                         KBlock *target) const {
   KFunction *currentKF = kb->parent;
-  std::vector<KBlock *> &localTargets = currentKF->returnKBlocks;
+  const std::vector<KBlock *> &localTargets = currentKF->getReturnKBlocks();
 
   if (localTargets.empty())
     return Miss;
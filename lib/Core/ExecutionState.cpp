@@ -10,6 +10,7 @@
 #include "ExecutionState.h"
 
 #include "ConstructStorage.h"
+#include "CoreStats.h"
 #include "Memory.h"
 
 #include "klee/Expr/ArrayExprVisitor.h"
@@ -29,9 +30,11 @@ DISABLE_WARNING_DEPRECATED_DECLARATIONS
 #include "llvm/Support/raw_ostream.h"
 DISABLE_WARNING_POP
 
+#include <algorithm>
 #include <cassert>
 #include <fstream>
 #include <iomanip>
+#include <iterator>
 #include <set>
 #include <sstream>
 #include <string>
@@ -48,6 +51,13 @@ cl::opt<unsigned long long> MaxCyclesBeforeStuck(
 }
 
 namespace {
+cl::opt<unsigned> MaxResolutionCacheSize(
+    "max-resolution-cache-size",
+    cl::desc("Maximal number of memoized null or bounds checks of symbolic "
+             "addresses per state; a full cache is emptied.  Set to 0 to "
+             "disable the limit (default=1024)"),
+    cl::init(1024), cl::cat(ExecCat));
+
 cl::opt<bool> UseGEPOptimization(
     "use-gep-opt", cl::init(true),
     cl::desc("Lazily initialize whole objects referenced by gep expressions "
@@ -63,7 +73,7 @@ std::uint32_t ExecutionState::nextID = 1;
 /***/
 
 void ExecutionStack::pushFrame(KInstIterator caller, KFunction *kf) {
-  valueStack_.emplace_back(StackFrame(kf));
+  valueStack_.push_back(kf);
   if (std::find(callStack_.begin(), callStack_.end(),
                 CallStackFrame(caller, kf)) == callStack_.end()) {
     uniqueFrames_.emplace_back(CallStackFrame(caller, kf));
@@ -113,6 +123,15 @@ StackFrame::StackFrame(const StackFrame &s)
 
 StackFrame::~StackFrame() {}
 
+StackFrame &ValueStack::writeable(size_t i) {
+  ref<StackFrame> &frame = frames[i];
+  if (frame->_refCount.getCount() > 1) {
+    frame = new StackFrame(*frame);
+    ++stats::copiedFrames;
+  }
+  return *frame;
+}
+
 InfoStackFrame::InfoStackFrame(KFunction *kf) : kf(kf) {}
 
 /***/
@@ -128,7 +147,7 @@ ExecutionState::ExecutionState()
 }
 
 ExecutionState::ExecutionState(KFunction *kf)
-    : initPC(kf->instructions), pc(initPC), prevPC(pc), incomingBBIndex(-1),
+    : initPC(kf->getInstructions()), pc(initPC), prevPC(pc), incomingBBIndex(-1),
       depth(0), ptreeNode(nullptr), symbolics(), steppedInstructions(0),
       steppedMemoryInstructions(0), instsSinceCovNew(0),
       roundingMode(llvm::APFloat::rmNearestTiesToEven), coveredNew({}),
@@ -176,9 +195,11 @@ ExecutionState::ExecutionState(const ExecutionState &state)
       coveredNew(state.coveredNew), coveredNewError(state.coveredNewError),
       forkDisabled(state.forkDisabled), returnValue(state.returnValue),
       gepExprBases(state.gepExprBases), multiplexKF(state.multiplexKF),
+      joinPoints(state.joinPoints),
       prevTargets_(state.prevTargets_), targets_(state.targets_),
       prevHistory_(state.prevHistory_), history_(state.history_),
-      isTargeted_(state.isTargeted_) {
+      isTargeted_(state.isTargeted_),
+      resolutionCache(state.resolutionCache) {
   queryMetaData.id = state.id;
 }
 
@@ -203,12 +224,171 @@ bool ExecutionState::inSymbolics(const MemoryObject *mo) const {
   return false;
 }
 
+bool ExecutionState::merge(const ExecutionState &b, unsigned maxSelects) {
+  if (pc != b.pc || stack.callStack() != b.stack.callStack() ||
+      forkDisabled != b.forkDisabled || roundingMode != b.roundingMode ||
+      unwindingInformation || b.unwindingInformation) {
+    return false;
+  }
+
+  if (symbolics.size() != b.symbolics.size()) {
+    return false;
+  }
+  for (auto ai = symbolics.begin(), bi = b.symbolics.begin();
+       ai != symbolics.end(); ++ai, ++bi) {
+    if (!(*ai == *bi)) {
+      return false;
+    }
+  }
+
+  // Symcretes tie constraints to concrete values chosen along one path only
+  if (!constraints.cs().symcretes().empty() ||
+      !b.constraints.cs().symcretes().empty()) {
+    return false;
+  }
+
+  // Addresses must resolve identically in both states: objects allocated
+  // since the branch must have been freed, and no pre-existing object may
+  // have been freed in only one of them.
+  std::vector<const MemoryObject *> mutated;
+  auto ai = addressSpace.objects.begin(), ae = addressSpace.objects.end();
+  auto bi = b.addressSpace.objects.begin(), be = b.addressSpace.objects.end();
+  for (; ai != ae && bi != be; ++ai, ++bi) {
+    if (ai->first != bi->first) {
+      return false;
+    }
+    if (ai->second.get() != bi->second.get()) {
+      if (!isa<ConstantExpr>(ai->first->getSizeExpr()) ||
+          ai->second->readOnly) {
+        return false;
+      }
+      mutated.push_back(ai->first);
+    }
+  }
+  if (ai != ae || bi != be) {
+    return false;
+  }
+
+  unsigned selects = 0;
+  const auto &aFrames = stack.valueStack();
+  const auto &bFrames = b.stack.valueStack();
+  for (size_t f = 0; f < aFrames.size(); ++f) {
+    const auto &aLocals = *aFrames[f].locals;
+    const auto &bLocals = *bFrames[f].locals;
+    for (size_t i = 0; i < aLocals.size(); ++i) {
+      const ref<Expr> &av = aLocals.at(i).value();
+      const ref<Expr> &bv = bLocals.at(i).value();
+      if (av && bv && av != bv) {
+        ++selects;
+      }
+    }
+  }
+  for (auto mo : mutated) {
+    selects += addressSpace.findObject(mo).second->countDifferentBytes(
+        *b.addressSpace.findObject(mo).second);
+  }
+  if (maxSelects && selects > maxSelects) {
+    return false;
+  }
+
+  const constraints_ty &aConstraints = constraints.original();
+  const constraints_ty &bConstraints = b.constraints.original();
+  constraints_ty commonConstraints, aSuffix, bSuffix;
+  std::set_intersection(aConstraints.begin(), aConstraints.end(),
+                        bConstraints.begin(), bConstraints.end(),
+                        std::inserter(commonConstraints,
+                                      commonConstraints.begin()),
+                        aConstraints.value_comp());
+  std::set_difference(aConstraints.begin(), aConstraints.end(),
+                      commonConstraints.begin(), commonConstraints.end(),
+                      std::inserter(aSuffix, aSuffix.begin()),
+                      aConstraints.value_comp());
+  std::set_difference(bConstraints.begin(), bConstraints.end(),
+                      commonConstraints.begin(), commonConstraints.end(),
+                      std::inserter(bSuffix, bSuffix.begin()),
+                      bConstraints.value_comp());
+
+  ref<Expr> inA = ConstantExpr::alloc(1, Expr::Bool);
+  ref<Expr> inB = ConstantExpr::alloc(1, Expr::Bool);
+  for (const auto &constraint : aSuffix) {
+    inA = AndExpr::create(inA, constraint);
+  }
+  for (const auto &constraint : bSuffix) {
+    inB = AndExpr::create(inB, constraint);
+  }
+
+  // Nothing may fail from here on
+  auto &values = stack.valueStack();
+  for (size_t f = 0; f < values.size(); ++f) {
+    auto &aLocals = *values[f].locals;
+    const auto &bLocals = *bFrames[f].locals;
+    for (size_t i = 0; i < aLocals.size(); ++i) {
+      ref<Expr> av = aLocals.at(i).value();
+      const ref<Expr> &bv = bLocals.at(i).value();
+      // A local defined in only one of the states cannot be used past the
+      // join point, so it is left as is
+      if (av && bv && av != bv) {
+        aLocals.set(i, Cell(SelectExpr::create(inA, av, bv)));
+      }
+    }
+  }
+
+  for (auto mo : mutated) {
+    const ObjectState *os = addressSpace.findObject(mo).second;
+    const ObjectState *otherOS = b.addressSpace.findObject(mo).second;
+    ObjectState *wos = addressSpace.getWriteable(mo, os);
+    wos->merge(inA, *otherOS);
+  }
+
+  PathConstraints merged;
+  merged.advancePath(constraints.path());
+  for (const auto &constraint : commonConstraints) {
+    auto index = constraints.indexes().find(constraint);
+    if (index != constraints.indexes().end()) {
+      merged.addConstraint(constraint, index->second);
+    } else {
+      merged.addConstraint(constraint);
+    }
+  }
+  merged.addConstraint(OrExpr::create(inA, inB));
+  constraints = merged;
+  resolutionCache = ResolutionCache();
+
+  // Only resolutions valid in both states are kept as hints
+  for (auto it = resolvedPointers.begin(); it != resolvedPointers.end();) {
+    auto other = b.resolvedPointers.find(it->first);
+    if (other == b.resolvedPointers.end()) {
+      it = resolvedPointers.erase(it);
+    } else {
+      it->second.insert(other->second.begin(), other->second.end());
+      ++it;
+    }
+  }
+  for (auto it = resolvedSubobjects.begin(); it != resolvedSubobjects.end();) {
+    auto other = b.resolvedSubobjects.find(it->first);
+    if (other == b.resolvedSubobjects.end()) {
+      it = resolvedSubobjects.erase(it);
+    } else {
+      it->second.insert(other->second.begin(), other->second.end());
+      ++it;
+    }
+  }
+  gepExprBases.insert(b.gepExprBases.begin(), b.gepExprBases.end());
+  for (const auto &[file, lines] : b.coveredLines) {
+    coveredLines[file].insert(lines.begin(), lines.end());
+  }
+  for (const auto &covered : b.coveredNew) {
+    coveredNew.push_back(covered);
+  }
+  return true;
+}
+
 ExecutionState *ExecutionState::withStackFrame(KInstIterator caller,
                                                KFunction *kf) {
   ExecutionState *newState = new ExecutionState(*this);
   newState->setID();
   newState->pushFrame(caller, kf);
-  newState->initPC = kf->blockMap[&*kf->function()->begin()]->instructions;
+  newState->initPC = kf->getEntryKBlock()->instructions;
   newState->pc = newState->initPC;
   newState->prevPC = newState->pc;
   return newState;
@@ -288,6 +468,26 @@ bool ExecutionState::getBase(
   return true;
 }
 
+void ExecutionState::ResolutionCache::addNonNullBase(ref<Expr> base) {
+  if (MaxResolutionCacheSize && nonNullBases.size() >= MaxResolutionCacheSize)
+    nonNullBases = PersistentSet<ref<Expr>, util::ExprLess>();
+  nonNullBases.insert(base);
+}
+
+void ExecutionState::ResolutionCache::addInBounds(ref<Expr> address,
+                                                  ref<const MemoryObject> mo,
+                                                  unsigned bytes) {
+  if (MaxResolutionCacheSize && inBounds.size() >= MaxResolutionCacheSize)
+    inBounds.clear();
+  inBounds.replace({address, {mo, bytes}});
+}
+
+ExecutionState::ResolutionCache &ExecutionState::getResolutionCache() {
+  if (resolutionCache.epoch != constraints.epoch())
+    resolutionCache = ResolutionCache{constraints.epoch()};
+  return resolutionCache;
+}
+
 void ExecutionState::removePointerResolutions(const MemoryObject *mo) {
   for (auto resolution = begin(resolvedPointers);
        resolution != end(resolvedPointers);) {
@@ -308,6 +508,13 @@ void ExecutionState::removePointerResolutions(const MemoryObject *mo) {
       ++resolution;
     }
   }
+
+  std::vector<ref<Expr>> staleInBounds;
+  for (const auto &resolution : resolutionCache.inBounds)
+    if (resolution.second.first.get() == mo)
+      staleInBounds.push_back(resolution.first);
+  for (const auto &address : staleInBounds)
+    resolutionCache.inBounds.remove(address);
 }
 
 void ExecutionState::removePointerResolutions(ref<PointerExpr> address,
@@ -316,6 +523,7 @@ void ExecutionState::removePointerResolutions(ref<PointerExpr> address,
   if (!isa<ConstantExpr>(base)) {
     resolvedPointers[base].clear();
     resolvedSubobjects[MemorySubobject(address, size)].clear();
+    resolutionCache.inBounds.remove(address);
   }
 }
 
@@ -366,7 +574,7 @@ void ExecutionState::dumpStack(llvm::raw_ostream &out) const {
 
     Function *f = csf.kf->function();
     out << "\t#" << i;
-    auto assemblyLine = target->getKModule()->getAsmLine(target->inst());
+    auto assemblyLine = target->getKModule()->getAsmLine(target);
     if (assemblyLine.has_value()) {
       std::stringstream AsmStream;
       AsmStream << std::setw(8) << std::setfill('0') << assemblyLine.value();
@@ -383,7 +591,7 @@ void ExecutionState::dumpStack(llvm::raw_ostream &out) const {
       if (ai->hasName())
         out << ai->getName().str() << "=";
 
-      ref<Expr> value = sf.locals->at(csf.kf->getArgRegister(index++)).value;
+      ref<Expr> value = sf.locals->at(csf.kf->getArgRegister(index++)).value();
       if (isa_and_nonnull<ConstantExpr>(value)) {
         out << value;
       } else if (isa_and_nonnull<ConstantPointerExpr>(value)) {
@@ -15,6 +15,7 @@
 #include "klee/ADT/FixedSizeStorageAdapter.h"
 #include "klee/ADT/ImmutableList.h"
 #include "klee/ADT/ImmutableSet.h"
+#include "klee/ADT/PersistentHashMap.h"
 #include "klee/ADT/PersistentMap.h"
 #include "klee/ADT/PersistentSet.h"
 #include "klee/ADT/SparseStorage.h"
@@ -103,11 +104,40 @@ struct StackFrame {
   // of intrinsic lowering.
   MemoryObject *varargs;
 
+  /// @brief Required by klee::ref-managed objects
+  class ReferenceCounter _refCount;
+
   StackFrame(KFunction *kf);
   StackFrame(const StackFrame &s);
   ~StackFrame();
 };
 
+/// Stack of value frames shared between states. Copying the stack only copies
+/// references to the frames, and a frame that is shared with another stack is
+/// cloned the first time it is accessed for modification.
+class ValueStack {
+  std::vector<ref<StackFrame>> frames;
+
+  StackFrame &writeable(size_t i);
+
+public:
+  size_t size() const { return frames.size(); }
+  bool empty() const { return frames.empty(); }
+
+  const StackFrame &operator[](size_t i) const { return *frames[i]; }
+  StackFrame &operator[](size_t i) { return writeable(i); }
+  const StackFrame &at(size_t i) const { return *frames.at(i); }
+  StackFrame &at(size_t i) {
+    assert(i < frames.size() && "frame index out of range");
+    return writeable(i);
+  }
+  const StackFrame &back() const { return *frames.back(); }
+  StackFrame &back() { return writeable(frames.size() - 1); }
+
+  void push_back(KFunction *kf) { frames.push_back(new StackFrame(kf)); }
+  void pop_back() { frames.pop_back(); }
+};
+
 struct InfoStackFrame {
   KFunction *kf;
   CallPathNode *callPathNode = nullptr;
@@ -127,7 +157,7 @@ struct InfoStackFrame {
 
 struct ExecutionStack {
 public:
-  using value_stack_ty = std::vector<StackFrame>;
+  using value_stack_ty = ValueStack;
   using call_stack_ty = std::vector<CallStackFrame>;
   using info_stack_ty = std::vector<InfoStackFrame>;
 
@@ -376,6 +406,30 @@ public:
                      MemorySubobjectHash, MemorySubobjectCompare>
       resolvedSubobjects;
 
+  /// @brief Memoized outcomes of the null and bounds checks performed on
+  /// symbolic addresses. Adding constraints cannot invalidate them, so they
+  /// are inherited by forked states; they are dropped when the constraints
+  /// start a new epoch (see PathConstraints::epoch()). Both containers are
+  /// persistent, so forking shares them instead of copying, and each is
+  /// emptied once it reaches --max-resolution-cache-size entries.
+  struct ResolutionCache {
+    using InBoundsMap =
+        PersistentHashMap<ref<Expr>,
+                          std::pair<ref<const MemoryObject>, unsigned>,
+                          util::ExprHash, util::ExprCmp>;
+
+    std::uint64_t epoch = 0;
+    /// Symbolic bases that cannot be null
+    PersistentSet<ref<Expr>, util::ExprLess> nonNullBases;
+    /// Addresses that must point into the given object for accesses of up
+    /// to the given number of bytes
+    InBoundsMap inBounds;
+
+    void addNonNullBase(ref<Expr> base);
+    void addInBounds(ref<Expr> address, ref<const MemoryObject> mo,
+                     unsigned bytes);
+  };
+
   /// @brief A set of boolean expressions
   /// the user has requested be true of a counterexample.
   ImmutableSet<ref<Expr>> cexPreferences;
@@ -428,6 +482,11 @@ public:
   // Temp: to know which multiplex path this state has taken
   KFunction *multiplexKF = nullptr;
 
+  /// @brief Pending join points of symbolic branches taken by this state:
+  /// the first instruction of the immediate post-dominator of the branch
+  /// block, paired with the stack size at the time of the branch
+  std::vector<std::pair<KInstruction *, unsigned>> joinPoints;
+
 private:
   PersistentSet<ref<Target>> prevTargets_;
   PersistentSet<ref<Target>> targets_;
@@ -435,6 +494,7 @@ private:
   ref<TargetsHistory> history_;
   bool isTargeted_ = false;
   bool areTargetsChanged_ = false;
+  ResolutionCache resolutionCache;
 
 public:
   // only to create the initial state
@@ -459,6 +519,16 @@ public:
 
   bool inSymbolics(const MemoryObject *mo) const;
 
+  /// @brief Merges state `b` into this state if both are at the same
+  /// instruction with the same call stack and the same set of allocated
+  /// objects. Differing locals and memory bytes are joined with `select`
+  /// over the path conditions since the common prefix.
+  /// @param maxSelects Upper bound on the number of `select` expressions the
+  /// merge may introduce (0 means unbounded).
+  /// @return true iff the states were merged; on failure this state is left
+  /// untouched.
+  bool merge(const ExecutionState &b, unsigned maxSelects);
+
   void pushFrame(KInstIterator caller, KFunction *kf);
   void popFrame();
 
@@ -470,6 +540,7 @@ public:
   bool getBase(ref<Expr> expr,
                std::pair<ref<const MemoryObject>, ref<Expr>> &resolution) const;
 
+  ResolutionCache &getResolutionCache();
   void removePointerResolutions(const MemoryObject *mo);
   void removePointerResolutions(ref<PointerExpr> address, unsigned size);
   void addPointerResolution(ref<PointerExpr> address, const MemoryObject *mo,
@@ -548,7 +619,7 @@ public:
       return level != ml.end() && level->second > bound;
     }
     if (pc == pc->parent->getFirstInstruction() &&
-        pc->parent == pc->parent->parent->entryKBlock) {
+        pc->parent == pc->parent->parent->getEntryKBlock()) {
       auto level = stack.multilevel.at(stack.callStack().back().kf);
       return level > bound;
     }
@@ -564,7 +635,7 @@ public:
       return level != ml.end() && level->second > bound;
     }
     if (pc == pc->parent->getFirstInstruction() &&
-        pc->parent == pc->parent->parent->entryKBlock) {
+        pc->parent == pc->parent->parent->getEntryKBlock()) {
       auto level = stack.multilevel.at(stack.callStack().back().kf);
       return level > bound;
     }
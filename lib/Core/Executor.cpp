@@ -99,8 +99,10 @@ DISABLE_WARNING_DEPRECATED_DECLARATIONS
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Process.h"
+#include "llvm/Support/SwapByteOrder.h"
 #if LLVM_VERSION_CODE >= LLVM_VERSION(10, 0)
 #include "llvm/Support/TypeSize.h"
 #else
@@ -180,6 +182,27 @@ cl::opt<bool>
                                       "and return null (default=false)"),
                              cl::cat(ExecCat));
 
+cl::opt<unsigned> StateMergingMaxSelects(
+    "state-merging-max-selects", cl::init(64),
+    cl::desc("Do not merge two states if this would introduce more than this "
+             "many select expressions over locals and memory bytes when using "
+             "--use-state-merging. Set to 0 to disable (default=64)"),
+    cl::cat(ExecCat));
+
+cl::opt<bool> LazyGlobalContents(
+    "lazy-global-contents", cl::init(true),
+    cl::desc("Defer writing the contents of globals initialized with plain "
+             "integer data arrays into memory until they are first accessed "
+             "(default=true)"),
+    cl::cat(ExecCat));
+
+cl::opt<bool> SummarizePureCalls(
+    "summarize-pure-calls", cl::init(false),
+    cl::desc("Reuse the result of earlier calls to runtime functions that do "
+             "not access memory when they are called again with the same "
+             "concrete arguments (default=false)"),
+    cl::cat(ExecCat));
+
 cl::opt<size_t> OSCopySizeMemoryCheckThreshold(
     "os-copy-size-mem-check-threshold", cl::init(30000),
     cl::desc("Check memory usage when this amount of bytes dense OS is copied"),
@@ -228,6 +251,12 @@ llvm::cl::opt<unsigned> MinNumberElementsLazyInit(
     llvm::cl::desc("Minimum number of array elements for one lazy "
                    "initialization (default 4)"),
     llvm::cl::init(4), llvm::cl::cat(LazyInitCat));
+
+cl::opt<std::string> PreparedModuleCache(
+    "prepared-module-cache", cl::init(""),
+    cl::desc("Directory where modules prepared for execution are stored and "
+             "reused by later runs on the same inputs (default=off)"),
+    cl::cat(ModuleCat));
 } // namespace
 
 cl::opt<std::string> FunctionCallReproduce(
@@ -350,6 +379,14 @@ cl::opt<bool> SuppressExternalWarnings(
     cl::desc("Supress warnings about calling external functions."),
     cl::cat(ExtCallsCat));
 
+cl::opt<bool> ExternalCallsSyncReachable(
+    "external-calls-sync-reachable", cl::init(false),
+    cl::desc("Before and after an external call, only synchronize the "
+             "objects reachable from the call arguments (and objects at fixed "
+             "addresses) with native memory, instead of the whole address "
+             "space (default=false)"),
+    cl::cat(ExtCallsCat));
+
 cl::opt<bool> AllExternalWarnings(
     "all-external-warnings", cl::init(false),
     cl::desc("Issue a warning everytime an external call is made, "
@@ -597,18 +634,14 @@ Executor::Executor(LLVMContext &ctx, const InterpreterOptions &opts,
   }
 }
 
-llvm::Module *Executor::setModule(
+void Executor::linkModules(
     std::vector<std::unique_ptr<llvm::Module>> &userModules,
     std::vector<std::unique_ptr<llvm::Module>> &libsModules,
-    const ModuleOptions &opts, std::set<std::string> &&mainModuleFunctions,
-    std::set<std::string> &&mainModuleGlobals, FLCtoOpcode &&origInstructions,
+    const std::string &intrinsicsPath, const ModuleOptions &opts,
+    bool useMocks, std::set<std::string> &mainModuleFunctions,
+    std::set<std::string> &mainModuleGlobals,
     const std::set<std::string> &ignoredExternals,
-    std::vector<std::pair<std::string, std::string>> redefinitions) {
-  assert(!kmodule && !userModules.empty() &&
-         "can only register one module"); // XXX gross
-
-  kmodule = std::make_unique<KModule>();
-
+    std::vector<std::pair<std::string, std::string>> &redefinitions) {
   // 1.) Link the modules together && 2.) Apply different instrumentation
   kmodule->link(userModules, 1);
   kmodule->instrument(opts);
@@ -619,21 +652,18 @@ llvm::Module *Executor::setModule(
   {
     std::vector<std::unique_ptr<llvm::Module>> modules;
     // Link with KLEE intrinsics library before running any optimizations
-    SmallString<128> LibPath(opts.LibraryDir);
-    llvm::sys::path::append(LibPath, "libkleeRuntimeIntrinsic" +
-                                         opts.OptSuffix + ".bca");
     std::string error;
-    if (!klee::loadFileAsOneModule(
-            LibPath.c_str(), kmodule->module->getContext(), modules, error)) {
-      klee_error("Could not load KLEE intrinsic file %s", LibPath.c_str());
+    if (!klee::loadFileAsOneModule(intrinsicsPath.c_str(),
+                                   kmodule->module->getContext(), modules,
+                                   error)) {
+      klee_error("Could not load KLEE intrinsic file %s",
+                 intrinsicsPath.c_str());
     }
     kmodule->link(modules, 2);
     kmodule->instrument(opts);
   }
 
-  if (interpreterOpts.Mock == MockPolicy::All ||
-      interpreterOpts.MockMutableGlobals == MockMutableGlobalsPolicy::All ||
-      !opts.AnnotationsFile.empty()) {
+  if (useMocks) {
     MockBuilder mockBuilder(kmodule->module.get(), opts, interpreterOpts,
                             ignoredExternals, redefinitions, interpreterHandler,
                             mainModuleFunctions, mainModuleGlobals);
@@ -657,6 +687,61 @@ llvm::Module *Executor::setModule(
       }
     }
   }
+}
+
+llvm::Module *Executor::setModule(
+    std::vector<std::unique_ptr<llvm::Module>> &userModules,
+    std::vector<std::unique_ptr<llvm::Module>> &libsModules,
+    const ModuleOptions &opts, std::set<std::string> &&mainModuleFunctions,
+    std::set<std::string> &&mainModuleGlobals, FLCtoOpcode &&origInstructions,
+    const std::set<std::string> &ignoredExternals,
+    std::vector<std::pair<std::string, std::string>> redefinitions) {
+  assert(!kmodule && !userModules.empty() &&
+         "can only register one module"); // XXX gross
+
+  kmodule = std::make_unique<KModule>();
+
+  SmallString<128> LibPath(opts.LibraryDir);
+  llvm::sys::path::append(LibPath,
+                          "libkleeRuntimeIntrinsic" + opts.OptSuffix + ".bca");
+
+  // Mocks are generated from the linked module and report back which
+  // functions and globals they replaced, so they are never cached
+  bool useMocks =
+      interpreterOpts.Mock == MockPolicy::All ||
+      interpreterOpts.MockMutableGlobals == MockMutableGlobalsPolicy::All ||
+      !opts.AnnotationsFile.empty();
+
+  std::string preparedModulePath;
+  bool loadedPreparedModule = false;
+  if (!PreparedModuleCache.empty() && !useMocks) {
+    auto intrinsics = llvm::MemoryBuffer::getFile(LibPath);
+    if (!intrinsics) {
+      klee_error("Could not load KLEE intrinsic file %s", LibPath.c_str());
+    }
+    std::vector<const llvm::Module *> inputs;
+    for (const auto &m : userModules)
+      inputs.push_back(m.get());
+    for (const auto &m : libsModules)
+      inputs.push_back(m.get());
+    StringRef extra[] = {intrinsics.get()->getBuffer(),
+                         FunctionCallReproduce.getValue()};
+    SmallString<128> path(PreparedModuleCache.getValue());
+    llvm::sys::path::append(
+        path, KModule::getPreparedModuleKey(inputs, extra, opts) + ".bc");
+    preparedModulePath = path.str().str();
+    loadedPreparedModule = kmodule->loadPreparedModule(
+        preparedModulePath, userModules.front()->getContext(), opts);
+    if (loadedPreparedModule) {
+      klee_message("Loaded prepared module %s", preparedModulePath.c_str());
+    }
+  }
+
+  if (!loadedPreparedModule) {
+    linkModules(userModules, libsModules, LibPath.str().str(), opts,
+                useMocks, mainModuleFunctions, mainModuleGlobals,
+                ignoredExternals, redefinitions);
+  }
 
   // 3.) Optimise and prepare for KLEE
 
@@ -687,14 +772,19 @@ llvm::Module *Executor::setModule(
   // except the entry point
   preservedFunctions.push_back(opts.EntryPoint.c_str());
 
-  kmodule->optimiseAndPrepare(opts, preservedFunctions);
+  if (!loadedPreparedModule) {
+    kmodule->optimiseAndPrepare(opts, preservedFunctions);
+  }
   kmodule->checkModule();
+  if (!loadedPreparedModule && !preparedModulePath.empty()) {
+    kmodule->storePreparedModule(preparedModulePath);
+  }
 
   // 4.) Manifest the module
   std::swap(kmodule->mainModuleFunctions, mainModuleFunctions);
   std::swap(kmodule->mainModuleGlobals, mainModuleGlobals);
   kmodule->manifest(interpreterHandler, interpreterOpts.Guidance,
-                    StatsTracker::useStatistics());
+                    StatsTracker::useIStats());
 
   kmodule->origInstructions = origInstructions;
 
@@ -816,6 +906,21 @@ void Executor::initializeGlobalObject(ExecutionState &state, ObjectState *os,
   }
 }
 
+/// Returns the raw bytes of a global initialized with a plain integer data
+/// array, or an empty reference if the initializer has to be evaluated.
+static StringRef getRawGlobalContents(const GlobalVariable &v,
+                                      const MemoryObject *mo) {
+  const auto *cds = dyn_cast<ConstantDataSequential>(v.getInitializer());
+  if (!cds || !cds->getElementType()->isIntegerTy() ||
+      Context::get().isLittleEndian() != sys::IsLittleEndianHost)
+    return StringRef();
+  StringRef contents = cds->getRawDataValues();
+  auto sizeExpr = dyn_cast<klee::ConstantExpr>(mo->getSizeExpr());
+  if (!sizeExpr || sizeExpr->getZExtValue() != contents.size())
+    return StringRef();
+  return contents;
+}
+
 ObjectPair Executor::addExternalObjectAsNonStatic(ExecutionState &state,
                                                   KType *type, unsigned size,
                                                   bool isReadOnly) {
@@ -1205,7 +1310,13 @@ void Executor::initializeGlobalObjects(ExecutionState &state) {
             SourceBuilder::irreproducible("unsizedGlobal"), false);
       }
     } else if (v.hasInitializer()) {
-      initializeGlobalObject(state, os, v.getInitializer(), 0);
+      StringRef contents;
+      if (LazyGlobalContents)
+        contents = getRawGlobalContents(v, mo);
+      if (!contents.empty())
+        os->setPendingContents(contents);
+      else
+        initializeGlobalObject(state, os, v.getInitializer(), 0);
       if (v.isConstant()) {
         os->setReadOnly(true);
         // initialise constant memory that may be used with external calls
@@ -1721,8 +1832,7 @@ const Cell &Executor::eval(const KInstruction *ki, unsigned index,
     return kmodule->constantTable[index];
   } else {
     unsigned index = vnumber;
-    ref<Expr> reg = sf.locals->at(index).value;
-    if (isSymbolic && reg.isNull()) {
+    if (isSymbolic && sf.locals->at(index).isNull()) {
       prepareSymbolicRegister(state, sf, index);
     }
     return sf.locals->at(index);
@@ -1731,7 +1841,19 @@ const Cell &Executor::eval(const KInstruction *ki, unsigned index,
 
 const Cell &Executor::eval(const KInstruction *ki, unsigned index,
                            ExecutionState &state, bool isSymbolic) {
-  return eval(ki, index, state, state.stack.valueStack().back(), isSymbolic);
+  // Read through the shared frame and only unshare it if a symbolic register
+  // has to be bound
+  int vnumber = ki->operands[index];
+  assert(vnumber != -1 &&
+         "Invalid operand to eval(), not a value or constant!");
+  if (vnumber < 0) {
+    return kmodule->constantTable[-vnumber - 2];
+  }
+  const StackFrame &sf = std::as_const(state.stack).valueStack().back();
+  if (isSymbolic && sf.locals->at(vnumber).isNull()) {
+    return eval(ki, index, state, state.stack.valueStack().back(), isSymbolic);
+  }
+  return sf.locals->at(vnumber);
 }
 
 void Executor::bindLocal(const KInstruction *target, StackFrame &frame,
@@ -1893,7 +2015,8 @@ void Executor::printDebugInstructions(ExecutionState &state) {
     (*stream) << "     " << state.pc->getSourceLocationString() << ':';
   }
   {
-    auto asmLine = state.pc->getKModule()->getAsmLine(state.pc->inst());
+    auto asmLine =
+        state.pc->getKModule()->getAsmLine(state.pc->getGlobalIndex());
     if (asmLine.has_value()) {
       (*stream) << asmLine.value() << ':';
     }
@@ -2156,7 +2279,7 @@ void Executor::unwindToNextLandingpad(ExecutionState &state) {
         KFunction *kf = kmodule->functionMap[personality_fn];
 
         state.pushFrame(state.prevPC, kf);
-        state.pc = kf->instructions;
+        state.pc = kf->getInstructions();
         state.increaseLevel();
         bindArgument(kf, 0, state, sui->exceptionObject);
         bindArgument(kf, 1, state, clauses_mo->getSizeExpr());
@@ -2266,7 +2389,7 @@ void Executor::executeCall(ExecutionState &state, KInstruction *ki, Function *f,
 
       bindLocal(ki, state, ConstantExpr::alloc(Res.bitcastToAPInt()));
 #else
-      ref<Expr> op = eval(ki, 1, state).value;
+      ref<Expr> op = eval(ki, 1, state).value();
       ref<Expr> result = FAbsExpr::create(op);
       bindLocal(ki, state, result);
 #endif
@@ -2274,7 +2397,7 @@ void Executor::executeCall(ExecutionState &state, KInstruction *ki, Function *f,
     }
 #ifdef ENABLE_FP
     case Intrinsic::sqrt: {
-      ref<Expr> op = eval(ki, 1, state).value;
+      ref<Expr> op = eval(ki, 1, state).value();
       ref<Expr> result = FSqrtExpr::create(op, state.roundingMode);
       bindLocal(ki, state, result);
       break;
@@ -2282,8 +2405,8 @@ void Executor::executeCall(ExecutionState &state, KInstruction *ki, Function *f,
 
     case Intrinsic::maxnum:
     case Intrinsic::minnum: {
-      ref<Expr> op1 = eval(ki, 1, state).value;
-      ref<Expr> op2 = eval(ki, 2, state).value;
+      ref<Expr> op1 = eval(ki, 1, state).value();
+      ref<Expr> op2 = eval(ki, 2, state).value();
       assert(op1->getWidth() == op2->getWidth() && "type mismatch");
       ref<Expr> result;
       if (f->getIntrinsicID() == Intrinsic::maxnum) {
@@ -2297,7 +2420,7 @@ void Executor::executeCall(ExecutionState &state, KInstruction *ki, Function *f,
     case Intrinsic::trunc: {
       FPTruncInst *fi = cast<FPTruncInst>(i);
       Expr::Width resultType = getWidthForLLVMType(fi->getType());
-      ref<Expr> arg = eval(ki, 0, state).value;
+      ref<Expr> arg = eval(ki, 0, state).value();
       if (!fpWidthToSemantics(arg->getWidth()) ||
           !fpWidthToSemantics(resultType))
         return terminateStateOnExecError(state,
@@ -2310,7 +2433,7 @@ void Executor::executeCall(ExecutionState &state, KInstruction *ki, Function *f,
       break;
     }
     case Intrinsic::rint: {
-      ref<Expr> arg = eval(ki, 0, state).value;
+      ref<Expr> arg = eval(ki, 0, state).value();
       ref<Expr> result = FRintExpr::create(arg, state.roundingMode);
       bindLocal(ki, state, result);
       break;
@@ -2330,11 +2453,11 @@ void Executor::executeCall(ExecutionState &state, KInstruction *ki, Function *f,
             state, f->getName() + " with vectors is not supported");
 
       ref<ConstantExpr> op1 =
-          toConstant(state, eval(ki, 1, state).value, "floating point");
+          toConstant(state, eval(ki, 1, state).value(), "floating point");
       ref<ConstantExpr> op2 =
-          toConstant(state, eval(ki, 2, state).value, "floating point");
+          toConstant(state, eval(ki, 2, state).value(), "floating point");
       ref<ConstantExpr> op3 =
-          toConstant(state, eval(ki, 3, state).value, "floating point");
+          toConstant(state, eval(ki, 3, state).value(), "floating point");
 
       if (!fpWidthToSemantics(op1->getWidth()) ||
           !fpWidthToSemantics(op2->getWidth()) ||
@@ -2352,9 +2475,9 @@ void Executor::executeCall(ExecutionState &state, KInstruction *ki, Function *f,
       bindLocal(ki, state, ConstantExpr::alloc(Res.bitcastToAPInt()));
       break;
 #else
-      ref<Expr> op1 = eval(ki, 1, state).value;
-      ref<Expr> op2 = eval(ki, 2, state).value;
-      ref<Expr> op3 = eval(ki, 3, state).value;
+      ref<Expr> op1 = eval(ki, 1, state).value();
+      ref<Expr> op2 = eval(ki, 2, state).value();
+      ref<Expr> op3 = eval(ki, 3, state).value();
       assert(op1->getWidth() == op2->getWidth() &&
              op2->getWidth() == op3->getWidth() && "type mismatch");
       ref<Expr> result =
@@ -2371,8 +2494,8 @@ void Executor::executeCall(ExecutionState &state, KInstruction *ki, Function *f,
         return terminateStateOnExecError(
             state, "llvm.abs with vectors is not supported");
 
-      ref<Expr> op = eval(ki, 1, state).value;
-      ref<Expr> poison = eval(ki, 2, state).value;
+      ref<Expr> op = eval(ki, 1, state).value();
+      ref<Expr> poison = eval(ki, 2, state).value();
 
       assert(poison->getWidth() == 1 && "Second argument is not an i1");
       unsigned bw = op->getWidth();
@@ -2413,8 +2536,8 @@ void Executor::executeCall(ExecutionState &state, KInstruction *ki, Function *f,
         return terminateStateOnExecError(
             state, "llvm.{s,u}{max,min} with vectors is not supported");
 
-      ref<Expr> op1 = eval(ki, 1, state).value;
-      ref<Expr> op2 = eval(ki, 2, state).value;
+      ref<Expr> op1 = eval(ki, 1, state).value();
+      ref<Expr> op2 = eval(ki, 2, state).value();
 
       ref<Expr> cond = nullptr;
       if (f->getIntrinsicID() == Intrinsic::smax)
@@ -2434,9 +2557,9 @@ void Executor::executeCall(ExecutionState &state, KInstruction *ki, Function *f,
 
     case Intrinsic::fshr:
     case Intrinsic::fshl: {
-      ref<Expr> op1 = eval(ki, 1, state).value;
-      ref<Expr> op2 = eval(ki, 2, state).value;
-      ref<Expr> op3 = eval(ki, 3, state).value;
+      ref<Expr> op1 = eval(ki, 1, state).value();
+      ref<Expr> op2 = eval(ki, 2, state).value();
+      ref<Expr> op3 = eval(ki, 3, state).value();
       unsigned w = op1->getWidth();
       assert(w == op2->getWidth() && "type mismatch");
       assert(w == op3->getWidth() && "type mismatch");
@@ -2547,6 +2670,28 @@ void Executor::executeCall(ExecutionState &state, KInstruction *ki, Function *f,
     // KInstIterator from just an instruction (unlike LLVM).
     KFunction *kf = kmodule->functionMap[f];
 
+    if (SummarizePureCalls && isSummarizable(kf) &&
+        arguments.size() >= f->arg_size()) {
+      CallSummaryKey key{kf, {}};
+      for (unsigned k = 0, e = f->arg_size(); k < e; ++k) {
+        auto ce = dyn_cast<ConstantExpr>(arguments[k]);
+        if (!ce || ce->getWidth() > Expr::Int64) {
+          key.first = nullptr;
+          break;
+        }
+        key.second.emplace_back(ce->getZExtValue(), ce->getWidth());
+      }
+      auto summary = key.first ? callSummaries.find(key) : callSummaries.end();
+      if (summary != callSummaries.end() &&
+          summary->second->getWidth() == getWidthForLLVMType(i->getType())) {
+        ++stats::summarizedCalls;
+        bindLocal(ki, state, summary->second);
+        if (InvokeInst *ii = dyn_cast<InvokeInst>(i))
+          transferToBasicBlock(ii->getNormalDest(), i->getParent(), state);
+        return;
+      }
+    }
+
     if (kmodule->inMainModule(*f) && kmodule->inMainModule(*i)) {
       state.eventsRecorder.record(new CallEvent(locationOf(state), kf));
     }
@@ -2732,7 +2877,7 @@ void Executor::transferToBasicBlock(KBlock *kdst, BasicBlock *src,
   // XXX this lookup has to go ?
   state.pc = kdst->instructions;
   state.increaseLevel();
-  if (state.pc->inst()->getOpcode() == Instruction::PHI) {
+  if (state.pc->getOpcode() == Instruction::PHI) {
     PHINode *first = static_cast<PHINode *>(state.pc->inst());
     state.incomingBBIndex = first->getBasicBlockIndex(src);
   }
@@ -2742,7 +2887,7 @@ void Executor::transferToBasicBlock(KBlock *kdst, BasicBlock *src,
 void Executor::transferToBasicBlock(BasicBlock *dst, BasicBlock *src,
                                     ExecutionState &state) {
   KFunction *kf = state.stack.callStack().back().kf;
-  auto kdst = kf->blockMap[dst];
+  auto kdst = kf->getBlockMap().at(dst);
   transferToBasicBlock(kdst, src, state);
 }
 
@@ -2778,6 +2923,93 @@ void Executor::checkNullCheckAfterDeref(ref<Expr> cond, ExecutionState &state) {
   }
 }
 
+bool Executor::executeConcreteInstruction(ExecutionState &state,
+                                          KInstruction *ki) {
+  using Op = KInstruction::ConcreteOp;
+  Op op = ki->getConcreteOp();
+  if (op == Op::None)
+    return false;
+
+  std::uint64_t left, right;
+  Expr::Width width, rightWidth;
+  if (!eval(ki, 0, state, false).getConcrete(left, width) ||
+      !eval(ki, 1, state, false).getConcrete(right, rightWidth)) {
+    return false;
+  }
+  assert(width == rightWidth && "type mismatch");
+
+  unsigned shift = Expr::Int64 - width;
+  std::uint64_t result;
+  switch (op) {
+  case Op::Add:
+    result = left + right;
+    break;
+  case Op::Sub:
+    result = left - right;
+    break;
+  case Op::Mul:
+    result = left * right;
+    break;
+  case Op::And:
+    result = left & right;
+    break;
+  case Op::Or:
+    result = left | right;
+    break;
+  case Op::Xor:
+    result = left ^ right;
+    break;
+  case Op::ICmpEQ:
+    result = left == right;
+    break;
+  case Op::ICmpNE:
+    result = left != right;
+    break;
+  case Op::ICmpUGT:
+    result = left > right;
+    break;
+  case Op::ICmpUGE:
+    result = left >= right;
+    break;
+  case Op::ICmpULT:
+    result = left < right;
+    break;
+  case Op::ICmpULE:
+    result = left <= right;
+    break;
+  case Op::ICmpSGT:
+    result = static_cast<std::int64_t>(left << shift) >
+             static_cast<std::int64_t>(right << shift);
+    break;
+  case Op::ICmpSGE:
+    result = static_cast<std::int64_t>(left << shift) >=
+             static_cast<std::int64_t>(right << shift);
+    break;
+  case Op::ICmpSLT:
+    result = static_cast<std::int64_t>(left << shift) <
+             static_cast<std::int64_t>(right << shift);
+    break;
+  case Op::ICmpSLE:
+    result = static_cast<std::int64_t>(left << shift) <=
+             static_cast<std::int64_t>(right << shift);
+    break;
+  default:
+    return false;
+  }
+  // Comparisons are the last operations in ConcreteOp
+  if (op >= Op::ICmpEQ)
+    width = Expr::Bool;
+
+  setDestCell(state, ki, Cell(bits64::truncateToNBits(result, width), width));
+  return true;
+}
+
+bool Executor::isSummarizable(const KFunction *kf) const {
+  const Function *f = kf->function();
+  return f->doesNotAccessMemory() && !f->isVarArg() &&
+         f->getReturnType()->isIntegerTy() && !kmodule->inMainModule(*f);
+}
+
 void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   Instruction *i = ki->inst();
 
@@ -2795,7 +3027,10 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
     }
   }
 
-  switch (i->getOpcode()) {
+  if (executeConcreteInstruction(state, ki))
+    return;
+
+  switch (ki->getOpcode()) {
     // Control flow
   case Instruction::Ret: {
     ReturnInst *ri = cast<ReturnInst>(i);
@@ -2805,7 +3040,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
     ref<Expr> result = ConstantExpr::alloc(0, Expr::Bool);
 
     if (!isVoidReturn) {
-      result = eval(ki, 0, state).value;
+      result = eval(ki, 0, state).value();
     }
 
     if (state.stack.size() <= 1) {
@@ -2826,6 +3061,24 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
             new ReturnEvent(locationOf(state), callerFunction));
       }
 
+      if (SummarizePureCalls && isa<ConstantExpr>(result) &&
+          isSummarizable(ki->getKFunction())) {
+        const KFunction *kf = ki->getKFunction();
+        const StackFrame &sf = std::as_const(state.stack).valueStack().back();
+        CallSummaryKey key{kf, {}};
+        for (unsigned k = 0, e = kf->getNumArgs(); k < e; ++k) {
+          std::uint64_t value;
+          Expr::Width width;
+          if (!sf.locals->at(k).getConcrete(value, width)) {
+            key.first = nullptr;
+            break;
+          }
+          key.second.emplace_back(value, width);
+        }
+        if (key.first)
+          callSummaries.emplace(std::move(key), result);
+      }
+
       state.popFrame();
 
       if (statsTracker)
@@ -2932,13 +3185,13 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
     } else {
       // FIXME: Find a way that we don't have this hidden dependency.
       assert(bi->getCondition() == bi->getOperand(0) && "Wrong operand index!");
-      ref<Expr> cond = eval(ki, 0, state).value;
+      ref<Expr> cond = eval(ki, 0, state).value();
 
       cond = optimizer.optimizeExpr(cond, false);
 
       KFunction *kf = state.stack.callStack().back().kf;
-      auto ifTrueBlock = kf->blockMap[bi->getSuccessor(0)];
-      auto ifFalseBlock = kf->blockMap[bi->getSuccessor(1)];
+      auto ifTrueBlock = kf->getBlockMap().at(bi->getSuccessor(0));
+      auto ifFalseBlock = kf->getBlockMap().at(bi->getSuccessor(1));
       Executor::StatePair branches =
           fork(state, cond, ifTrueBlock, ifFalseBlock, BranchType::Conditional);
 
@@ -2946,6 +3199,10 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
         maxNewStateStackSize =
             std::max(maxNewStateStackSize,
                      branches.first->stack.stackRegisterSize() * 8);
+        if (mergingSearcher) {
+          addJoinPoint(*branches.first, ki->parent);
+          addJoinPoint(*branches.second, ki->parent);
+        }
       }
 
       // NOTE: There is a hidden dependency here, markBranchVisited
@@ -2980,7 +3237,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   case Instruction::IndirectBr: {
     // implements indirect branch to a label within the current function
     const auto bi = cast<IndirectBrInst>(i);
-    auto address = eval(ki, 0, state).value;
+    auto address = eval(ki, 0, state).value();
     address = toUnique(state, address);
 
     // concrete address
@@ -3007,7 +3264,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
       const auto d = bi->getDestination(k);
       if (destinations.count(d))
         continue;
-      if (!canReachSomeTargetFromBlock(state, kf->blockMap[d]))
+      if (!canReachSomeTargetFromBlock(state, kf->getBlockMap().at(d)))
         continue;
       destinations.insert(d);
 
@@ -3061,7 +3318,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   }
   case Instruction::Switch: {
     SwitchInst *si = cast<SwitchInst>(i);
-    ref<Expr> cond = eval(ki, 0, state).value;
+    ref<Expr> cond = eval(ki, 0, state).value();
     BasicBlock *bb = si->getParent();
 
     cond = toUnique(state, cond);
@@ -3112,7 +3369,8 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
 
         notMatches.push_back(Expr::createIsZero(match));
 
-        if (!canReachSomeTargetFromBlock(state, kf->blockMap[caseSuccessor]))
+        if (!canReachSomeTargetFromBlock(state,
+                                         kf->getBlockMap().at(caseSuccessor)))
           continue;
 
         // Check if control flow could take this case
@@ -3165,7 +3423,8 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
         defaultValue = notMatches.back();
       }
 
-      if (canReachSomeTargetFromBlock(state, kf->blockMap[defaultDest])) {
+      if (canReachSomeTargetFromBlock(state,
+                                      kf->getBlockMap().at(defaultDest))) {
         // Check if control could take the default case
         defaultValue = optimizer.optimizeExpr(defaultValue, false);
         bool res;
@@ -3229,7 +3488,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
     arguments.reserve(numArgs);
 
     for (unsigned j = 0; j < numArgs; ++j)
-      arguments.push_back(eval(ki, j + 1, state).value);
+      arguments.push_back(eval(ki, j + 1, state).value());
 
     if (auto *asmValue =
             dyn_cast<InlineAsm>(fp)) { // TODO: move to `executeCall`
@@ -3281,7 +3540,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
 
       executeCall(state, ki, f, arguments);
     } else {
-      ref<Expr> v = eval(ki, 0, state).value;
+      ref<Expr> v = eval(ki, 0, state).value();
 
       ExecutionState *free = &state;
       bool hasInvalid = false, first = true;
@@ -3339,7 +3598,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
     if (state.incomingBBIndex == -1)
       prepareSymbolicValue(state, ki);
     else {
-      ref<Expr> result = eval(ki, state.incomingBBIndex, state).value;
+      ref<Expr> result = eval(ki, state.incomingBBIndex, state).value();
       bindLocal(ki, state, result);
     }
     break;
@@ -3348,9 +3607,9 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
     // Special instructions
   case Instruction::Select: {
     // NOTE: It is not required that operands 1 and 2 be of scalar type.
-    ref<Expr> cond = eval(ki, 0, state).value;
-    ref<Expr> tExpr = eval(ki, 1, state).value;
-    ref<Expr> fExpr = eval(ki, 2, state).value;
+    ref<Expr> cond = eval(ki, 0, state).value();
+    ref<Expr> tExpr = eval(ki, 1, state).value();
+    ref<Expr> fExpr = eval(ki, 2, state).value();
     ref<Expr> result = SelectExpr::create(cond, tExpr, fExpr);
     bindLocal(ki, state, result);
     break;
@@ -3363,101 +3622,101 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
     // Arithmetic / logical
 
   case Instruction::Add: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
+    ref<Expr> left = eval(ki, 0, state).value();
+    ref<Expr> right = eval(ki, 1, state).value();
     bindLocal(ki, state, AddExpr::create(left, right));
     break;
   }
 
   case Instruction::Sub: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
+    ref<Expr> left = eval(ki, 0, state).value();
+    ref<Expr> right = eval(ki, 1, state).value();
     bindLocal(ki, state, SubExpr::create(left, right));
     break;
   }
 
   case Instruction::Mul: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
+    ref<Expr> left = eval(ki, 0, state).value();
+    ref<Expr> right = eval(ki, 1, state).value();
     bindLocal(ki, state, MulExpr::create(left, right));
     break;
   }
 
   case Instruction::UDiv: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
+    ref<Expr> left = eval(ki, 0, state).value();
+    ref<Expr> right = eval(ki, 1, state).value();
     ref<Expr> result = UDivExpr::create(left, right);
     bindLocal(ki, state, result);
     break;
   }
 
   case Instruction::SDiv: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
+    ref<Expr> left = eval(ki, 0, state).value();
+    ref<Expr> right = eval(ki, 1, state).value();
     ref<Expr> result = SDivExpr::create(left, right);
     bindLocal(ki, state, result);
     break;
   }
 
   case Instruction::URem: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
+    ref<Expr> left = eval(ki, 0, state).value();
+    ref<Expr> right = eval(ki, 1, state).value();
     ref<Expr> result = URemExpr::create(left, right);
     bindLocal(ki, state, result);
     break;
   }
 
   case Instruction::SRem: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
+    ref<Expr> left = eval(ki, 0, state).value();
+    ref<Expr> right = eval(ki, 1, state).value();
     ref<Expr> result = SRemExpr::create(left, right);
     bindLocal(ki, state, result);
     break;
   }
 
   case Instruction::And: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
+    ref<Expr> left = eval(ki, 0, state).value();
+    ref<Expr> right = eval(ki, 1, state).value();
     ref<Expr> result = AndExpr::create(left, right);
     bindLocal(ki, state, result);
     break;
   }
 
   case Instruction::Or: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
+    ref<Expr> left = eval(ki, 0, state).value();
+    ref<Expr> right = eval(ki, 1, state).value();
     ref<Expr> result = OrExpr::create(left, right);
     bindLocal(ki, state, result);
     break;
   }
 
   case Instruction::Xor: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
+    ref<Expr> left = eval(ki, 0, state).value();
+    ref<Expr> right = eval(ki, 1, state).value();
     ref<Expr> result = XorExpr::create(left, right);
     bindLocal(ki, state, result);
     break;
   }
 
   case Instruction::Shl: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
+    ref<Expr> left = eval(ki, 0, state).value();
+    ref<Expr> right = eval(ki, 1, state).value();
     ref<Expr> result = ShlExpr::create(left, right);
     bindLocal(ki, state, result);
     break;
   }
 
   case Instruction::LShr: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
+    ref<Expr> left = eval(ki, 0, state).value();
+    ref<Expr> right = eval(ki, 1, state).value();
     ref<Expr> result = LShrExpr::create(left, right);
     bindLocal(ki, state, result);
     break;
   }
 
   case Instruction::AShr: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
+    ref<Expr> left = eval(ki, 0, state).value();
+    ref<Expr> right = eval(ki, 1, state).value();
     ref<Expr> result = AShrExpr::create(left, right);
     bindLocal(ki, state, result);
     break;
@@ -3471,80 +3730,80 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
 
     switch (ii->getPredicate()) {
     case ICmpInst::ICMP_EQ: {
-      ref<Expr> left = eval(ki, 0, state).value;
-      ref<Expr> right = eval(ki, 1, state).value;
+      ref<Expr> left = eval(ki, 0, state).value();
+      ref<Expr> right = eval(ki, 1, state).value();
       ref<Expr> result = EqExpr::create(left, right);
       bindLocal(ki, state, result);
       break;
     }
 
     case ICmpInst::ICMP_NE: {
-      ref<Expr> left = eval(ki, 0, state).value;
-      ref<Expr> right = eval(ki, 1, state).value;
+      ref<Expr> left = eval(ki, 0, state).value();
+      ref<Expr> right = eval(ki, 1, state).value();
       ref<Expr> result = NeExpr::create(left, right);
       bindLocal(ki, state, result);
       break;
     }
 
     case ICmpInst::ICMP_UGT: {
-      ref<Expr> left = eval(ki, 0, state).value;
-      ref<Expr> right = eval(ki, 1, state).value;
+      ref<Expr> left = eval(ki, 0, state).value();
+      ref<Expr> right = eval(ki, 1, state).value();
       ref<Expr> result = UgtExpr::create(left, right);
       bindLocal(ki, state, result);
       break;
     }
 
     case ICmpInst::ICMP_UGE: {
-      ref<Expr> left = eval(ki, 0, state).value;
-      ref<Expr> right = eval(ki, 1, state).value;
+      ref<Expr> left = eval(ki, 0, state).value();
+      ref<Expr> right = eval(ki, 1, state).value();
       ref<Expr> result = UgeExpr::create(left, right);
       bindLocal(ki, state, result);
       break;
     }
 
     case ICmpInst::ICMP_ULT: {
-      ref<Expr> left = eval(ki, 0, state).value;
-      ref<Expr> right = eval(ki, 1, state).value;
+      ref<Expr> left = eval(ki, 0, state).value();
+      ref<Expr> right = eval(ki, 1, state).value();
       ref<Expr> result = UltExpr::create(left, right);
       bindLocal(ki, state, result);
       break;
     }
 
     case ICmpInst::ICMP_ULE: {
-      ref<Expr> left = eval(ki, 0, state).value;
-      ref<Expr> right = eval(ki, 1, state).value;
+      ref<Expr> left = eval(ki, 0, state).value();
+      ref<Expr> right = eval(ki, 1, state).value();
       ref<Expr> result = UleExpr::create(left, right);
       bindLocal(ki, state, result);
       break;
     }
 
     case ICmpInst::ICMP_SGT: {
-      ref<Expr> left = eval(ki, 0, state).value;
-      ref<Expr> right = eval(ki, 1, state).value;
+      ref<Expr> left = eval(ki, 0, state).value();
+      ref<Expr> right = eval(ki, 1, state).value();
       ref<Expr> result = SgtExpr::create(left, right);
       bindLocal(ki, state, result);
       break;
     }
 
     case ICmpInst::ICMP_SGE: {
-      ref<Expr> left = eval(ki, 0, state).value;
-      ref<Expr> right = eval(ki, 1, state).value;
+      ref<Expr> left = eval(ki, 0, state).value();
+      ref<Expr> right = eval(ki, 1, state).value();
       ref<Expr> result = SgeExpr::create(left, right);
       bindLocal(ki, state, result);
       break;
     }
 
     case ICmpInst::ICMP_SLT: {
-      ref<Expr> left = eval(ki, 0, state).value;
-      ref<Expr> right = eval(ki, 1, state).value;
+      ref<Expr> left = eval(ki, 0, state).value();
+      ref<Expr> right = eval(ki, 1, state).value();
       ref<Expr> result = SltExpr::create(left, right);
       bindLocal(ki, state, result);
       break;
     }
 
     case ICmpInst::ICMP_SLE: {
-      ref<Expr> left = eval(ki, 0, state).value;
-      ref<Expr> right = eval(ki, 1, state).value;
+      ref<Expr> left = eval(ki, 0, state).value();
+      ref<Expr> right = eval(ki, 1, state).value();
       ref<Expr> result = SleExpr::create(left, right);
       bindLocal(ki, state, result);
       break;
@@ -3569,7 +3828,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
         kmodule->targetData->getTypeAllocSize(ai->getAllocatedType());
     ref<Expr> size = Expr::createPointer(elementSize);
     if (ai->isArrayAllocation()) {
-      ref<Expr> count = eval(ki, 0, state).value;
+      ref<Expr> count = eval(ki, 0, state).value();
       count = Expr::createZExtToPointerWidth(count);
       size = MulExpr::create(size, count);
     }
@@ -3579,7 +3838,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   }
 
   case Instruction::Load: {
-    ref<Expr> base = eval(ki, 0, state).value;
+    ref<Expr> base = eval(ki, 0, state).value();
     executeMemoryOperation(
         state, false,
         typeSystemManager->getWrappedType(
@@ -3588,8 +3847,8 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
     break;
   }
   case Instruction::Store: {
-    ref<Expr> base = eval(ki, 1, state).value;
-    ref<Expr> value = eval(ki, 0, state).value;
+    ref<Expr> base = eval(ki, 1, state).value();
+    ref<Expr> value = eval(ki, 0, state).value();
     executeMemoryOperation(
         state, true,
         typeSystemManager->getWrappedType(
@@ -3604,7 +3863,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
         static_cast<GetElementPtrInst *>(kgepi->inst());
     Expr::Width pointerWidthInBits = Context::get().getPointerWidth();
 
-    ref<Expr> base = eval(ki, 0, state).value;
+    ref<Expr> base = eval(ki, 0, state).value();
     ref<PointerExpr> pointer = makePointer(base);
     base = pointer->getBase();
     ref<Expr> offset = pointer->getOffset();
@@ -3614,7 +3873,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
              ie = kgepi->indices.end();
          it != ie; ++it) {
       uint64_t elementSize = it->second;
-      ref<Expr> index = eval(ki, it->first, state).value;
+      ref<Expr> index = eval(ki, it->first, state).value();
       offset = AddExpr::create(
           offset, MulExpr::create(Expr::createSExtToPointerWidth(index),
                                   Expr::createPointer(elementSize)));
@@ -3638,21 +3897,21 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
     // Conversion
   case Instruction::Trunc: {
     CastInst *ci = cast<CastInst>(i);
-    ref<Expr> result = ExtractExpr::create(eval(ki, 0, state).value, 0,
+    ref<Expr> result = ExtractExpr::create(eval(ki, 0, state).value(), 0,
                                            getWidthForLLVMType(ci->getType()));
     bindLocal(ki, state, result);
     break;
   }
   case Instruction::ZExt: {
     CastInst *ci = cast<CastInst>(i);
-    ref<Expr> result = ZExtExpr::create(eval(ki, 0, state).value,
+    ref<Expr> result = ZExtExpr::create(eval(ki, 0, state).value(),
                                         getWidthForLLVMType(ci->getType()));
     bindLocal(ki, state, result);
     break;
   }
   case Instruction::SExt: {
     CastInst *ci = cast<CastInst>(i);
-    ref<Expr> result = SExtExpr::create(eval(ki, 0, state).value,
+    ref<Expr> result = SExtExpr::create(eval(ki, 0, state).value(),
                                         getWidthForLLVMType(ci->getType()));
     bindLocal(ki, state, result);
     break;
@@ -3661,20 +3920,20 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   case Instruction::IntToPtr: {
     CastInst *ci = cast<CastInst>(i);
     Expr::Width pType = getWidthForLLVMType(ci->getType());
-    ref<Expr> arg = eval(ki, 0, state).value;
+    ref<Expr> arg = eval(ki, 0, state).value();
     bindLocal(ki, state, PointerExpr::create(ZExtExpr::create(arg, pType)));
     break;
   }
   case Instruction::PtrToInt: {
     CastInst *ci = cast<CastInst>(i);
     Expr::Width iType = getWidthForLLVMType(ci->getType());
-    ref<Expr> arg = eval(ki, 0, state).value;
+    ref<Expr> arg = eval(ki, 0, state).value();
     bindLocal(ki, state, ZExtExpr::create(arg, iType));
     break;
   }
 
   case Instruction::BitCast: {
-    ref<Expr> result = eval(ki, 0, state).value;
+    ref<Expr> result = eval(ki, 0, state).value();
     BitCastInst *bc = cast<BitCastInst>(ki->inst());
 
     llvm::Type *castToType = bc->getType();
@@ -3710,7 +3969,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
 #ifndef ENABLE_FP
   case Instruction::FNeg: {
     ref<ConstantExpr> arg =
-        toConstant(state, eval(ki, 0, state).value, "floating point");
+        toConstant(state, eval(ki, 0, state).value(), "floating point");
     if (!fpWidthToSemantics(arg->getWidth()))
       return terminateStateOnExecError(state, "Unsupported FNeg operation");
 
@@ -3722,9 +3981,9 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
 
   case Instruction::FAdd: {
     ref<ConstantExpr> left =
-        toConstant(state, eval(ki, 0, state).value, "floating point");
+        toConstant(state, eval(ki, 0, state).value(), "floating point");
     ref<ConstantExpr> right =
-        toConstant(state, eval(ki, 1, state).value, "floating point");
+        toConstant(state, eval(ki, 1, state).value(), "floating point");
     if (!fpWidthToSemantics(left->getWidth()) ||
         !fpWidthToSemantics(right->getWidth()))
       return terminateStateOnExecError(state, "Unsupported FAdd operation");
@@ -3740,9 +3999,9 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
 
   case Instruction::FSub: {
     ref<ConstantExpr> left =
-        toConstant(state, eval(ki, 0, state).value, "floating point");
+        toConstant(state, eval(ki, 0, state).value(), "floating point");
     ref<ConstantExpr> right =
-        toConstant(state, eval(ki, 1, state).value, "floating point");
+        toConstant(state, eval(ki, 1, state).value(), "floating point");
     if (!fpWidthToSemantics(left->getWidth()) ||
         !fpWidthToSemantics(right->getWidth()))
       return terminateStateOnExecError(state, "Unsupported FSub operation");
@@ -3757,9 +4016,9 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
 
   case Instruction::FMul: {
     ref<ConstantExpr> left =
-        toConstant(state, eval(ki, 0, state).value, "floating point");
+        toConstant(state, eval(ki, 0, state).value(), "floating point");
     ref<ConstantExpr> right =
-        toConstant(state, eval(ki, 1, state).value, "floating point");
+        toConstant(state, eval(ki, 1, state).value(), "floating point");
     if (!fpWidthToSemantics(left->getWidth()) ||
         !fpWidthToSemantics(right->getWidth()))
       return terminateStateOnExecError(state, "Unsupported FMul operation");
@@ -3775,9 +4034,9 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
 
   case Instruction::FDiv: {
     ref<ConstantExpr> left =
-        toConstant(state, eval(ki, 0, state).value, "floating point");
+        toConstant(state, eval(ki, 0, state).value(), "floating point");
     ref<ConstantExpr> right =
-        toConstant(state, eval(ki, 1, state).value, "floating point");
+        toConstant(state, eval(ki, 1, state).value(), "floating point");
     if (!fpWidthToSemantics(left->getWidth()) ||
         !fpWidthToSemantics(right->getWidth()))
       return terminateStateOnExecError(state, "Unsupported FDiv operation");
@@ -3793,9 +4052,9 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
 
   case Instruction::FRem: {
     ref<ConstantExpr> left =
-        toConstant(state, eval(ki, 0, state).value, "floating point");
+        toConstant(state, eval(ki, 0, state).value(), "floating point");
     ref<ConstantExpr> right =
-        toConstant(state, eval(ki, 1, state).value, "floating point");
+        toConstant(state, eval(ki, 1, state).value(), "floating point");
     if (!fpWidthToSemantics(left->getWidth()) ||
         !fpWidthToSemantics(right->getWidth()))
       return terminateStateOnExecError(state, "Unsupported FRem operation");
@@ -3811,7 +4070,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
     FPTruncInst *fi = cast<FPTruncInst>(i);
     Expr::Width resultType = getWidthForLLVMType(fi->getType());
     ref<ConstantExpr> arg =
-        toConstant(state, eval(ki, 0, state).value, "floating point");
+        toConstant(state, eval(ki, 0, state).value(), "floating point");
     if (!fpWidthToSemantics(arg->getWidth()) || resultType > arg->getWidth())
       return terminateStateOnExecError(state, "Unsupported FPTrunc operation");
 
@@ -3827,7 +4086,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
     FPExtInst *fi = cast<FPExtInst>(i);
     Expr::Width resultType = getWidthForLLVMType(fi->getType());
     ref<ConstantExpr> arg =
-        toConstant(state, eval(ki, 0, state).value, "floating point");
+        toConstant(state, eval(ki, 0, state).value(), "floating point");
     if (!fpWidthToSemantics(arg->getWidth()) || arg->getWidth() > resultType)
       return terminateStateOnExecError(state, "Unsupported FPExt operation");
     llvm::APFloat Res(*fpWidthToSemantics(arg->getWidth()), arg->getAPValue());
@@ -3842,7 +4101,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
     FPToUIInst *fi = cast<FPToUIInst>(i);
     Expr::Width resultType = getWidthForLLVMType(fi->getType());
     ref<ConstantExpr> arg =
-        toConstant(state, eval(ki, 0, state).value, "floating point");
+        toConstant(state, eval(ki, 0, state).value(), "floating point");
     if (!fpWidthToSemantics(arg->getWidth()) || resultType > 64)
       return terminateStateOnExecError(state, "Unsupported FPToUI operation");
 
@@ -3860,7 +4119,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
     FPToSIInst *fi = cast<FPToSIInst>(i);
     Expr::Width resultType = getWidthForLLVMType(fi->getType());
     ref<ConstantExpr> arg =
-        toConstant(state, eval(ki, 0, state).value, "floating point");
+        toConstant(state, eval(ki, 0, state).value(), "floating point");
     if (!fpWidthToSemantics(arg->getWidth()) || resultType > 64)
       return terminateStateOnExecError(state, "Unsupported FPToSI operation");
     llvm::APFloat Arg(*fpWidthToSemantics(arg->getWidth()), arg->getAPValue());
@@ -3878,7 +4137,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
     UIToFPInst *fi = cast<UIToFPInst>(i);
     Expr::Width resultType = getWidthForLLVMType(fi->getType());
     ref<ConstantExpr> arg =
-        toConstant(state, eval(ki, 0, state).value, "floating point");
+        toConstant(state, eval(ki, 0, state).value(), "floating point");
     const llvm::fltSemantics *semantics = fpWidthToSemantics(resultType);
     if (!semantics)
       return terminateStateOnExecError(state, "Unsupported UIToFP operation");
@@ -3894,7 +4153,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
     SIToFPInst *fi = cast<SIToFPInst>(i);
     Expr::Width resultType = getWidthForLLVMType(fi->getType());
     ref<ConstantExpr> arg =
-        toConstant(state, eval(ki, 0, state).value, "floating point");
+        toConstant(state, eval(ki, 0, state).value(), "floating point");
     const llvm::fltSemantics *semantics = fpWidthToSemantics(resultType);
     if (!semantics)
       return terminateStateOnExecError(state, "Unsupported SIToFP operation");
@@ -3909,9 +4168,9 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   case Instruction::FCmp: {
     FCmpInst *fi = cast<FCmpInst>(i);
     ref<ConstantExpr> left =
-        toConstant(state, eval(ki, 0, state).value, "floating point");
+        toConstant(state, eval(ki, 0, state).value(), "floating point");
     ref<ConstantExpr> right =
-        toConstant(state, eval(ki, 1, state).value, "floating point");
+        toConstant(state, eval(ki, 1, state).value(), "floating point");
     if (!fpWidthToSemantics(left->getWidth()) ||
         !fpWidthToSemantics(right->getWidth()))
       return terminateStateOnExecError(state, "Unsupported FCmp operation");
@@ -4004,8 +4263,8 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   }
 #else
   case Instruction::FAdd: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
+    ref<Expr> left = eval(ki, 0, state).value();
+    ref<Expr> right = eval(ki, 1, state).value();
     if (!fpWidthToSemantics(left->getWidth()) ||
         !fpWidthToSemantics(right->getWidth()))
       return terminateStateOnExecError(state, "Unsupported FAdd operation");
@@ -4015,8 +4274,8 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   }
 
   case Instruction::FSub: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
+    ref<Expr> left = eval(ki, 0, state).value();
+    ref<Expr> right = eval(ki, 1, state).value();
     if (!fpWidthToSemantics(left->getWidth()) ||
         !fpWidthToSemantics(right->getWidth()))
       return terminateStateOnExecError(state, "Unsupported FSub operation");
@@ -4026,8 +4285,8 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   }
 
   case Instruction::FMul: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
+    ref<Expr> left = eval(ki, 0, state).value();
+    ref<Expr> right = eval(ki, 1, state).value();
     if (!fpWidthToSemantics(left->getWidth()) ||
         !fpWidthToSemantics(right->getWidth()))
       return terminateStateOnExecError(state, "Unsupported FMul operation");
@@ -4037,8 +4296,8 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   }
 
   case Instruction::FDiv: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
+    ref<Expr> left = eval(ki, 0, state).value();
+    ref<Expr> right = eval(ki, 1, state).value();
     if (!fpWidthToSemantics(left->getWidth()) ||
         !fpWidthToSemantics(right->getWidth()))
       return terminateStateOnExecError(state, "Unsupported FDiv operation");
@@ -4048,14 +4307,14 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   }
 
   case Instruction::FNeg: {
-    ref<Expr> expr = eval(ki, 0, state).value;
+    ref<Expr> expr = eval(ki, 0, state).value();
     bindLocal(ki, state, FNegExpr::create(expr));
     break;
   }
 
   case Instruction::FRem: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
+    ref<Expr> left = eval(ki, 0, state).value();
+    ref<Expr> right = eval(ki, 1, state).value();
     if (!fpWidthToSemantics(left->getWidth()) ||
         !fpWidthToSemantics(right->getWidth()))
       return terminateStateOnExecError(state, "Unsupported FRem operation");
@@ -4067,7 +4326,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   case Instruction::FPTrunc: {
     FPTruncInst *fi = cast<FPTruncInst>(i);
     Expr::Width resultType = getWidthForLLVMType(fi->getType());
-    ref<Expr> arg = eval(ki, 0, state).value;
+    ref<Expr> arg = eval(ki, 0, state).value();
     if (!fpWidthToSemantics(arg->getWidth()) || !fpWidthToSemantics(resultType))
       return terminateStateOnExecError(state, "Unsupported FPTrunc operation");
     ref<Expr> result = arg;
@@ -4083,7 +4342,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   case Instruction::FPExt: {
     FPExtInst *fi = cast<FPExtInst>(i);
     Expr::Width resultType = getWidthForLLVMType(fi->getType());
-    ref<Expr> arg = eval(ki, 0, state).value;
+    ref<Expr> arg = eval(ki, 0, state).value();
     if (!fpWidthToSemantics(arg->getWidth()) || !fpWidthToSemantics(resultType))
       return terminateStateOnExecError(state, "Unsupported FPExt operation");
     ref<Expr> result = arg;
@@ -4101,7 +4360,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   case Instruction::FPToUI: {
     FPToUIInst *fi = cast<FPToUIInst>(i);
     Expr::Width resultType = getWidthForLLVMType(fi->getType());
-    ref<Expr> arg = eval(ki, 0, state).value;
+    ref<Expr> arg = eval(ki, 0, state).value();
     if (X86FPAsX87FP80 && Context::get().getPointerWidth() == 32) {
       arg = X87FP80ToFPTrunc(arg,
                              getWidthForLLVMType(fi->getOperand(0)->getType()),
@@ -4119,7 +4378,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   case Instruction::FPToSI: {
     FPToSIInst *fi = cast<FPToSIInst>(i);
     Expr::Width resultType = getWidthForLLVMType(fi->getType());
-    ref<Expr> arg = eval(ki, 0, state).value;
+    ref<Expr> arg = eval(ki, 0, state).value();
     if (X86FPAsX87FP80 && Context::get().getPointerWidth() == 32) {
       arg = X87FP80ToFPTrunc(arg,
                              getWidthForLLVMType(fi->getOperand(0)->getType()),
@@ -4140,7 +4399,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
     if (X86FPAsX87FP80 && Context::get().getPointerWidth() == 32) {
       resultType = Expr::Fl80;
     }
-    ref<Expr> arg = eval(ki, 0, state).value;
+    ref<Expr> arg = eval(ki, 0, state).value();
     const llvm::fltSemantics *semantics = fpWidthToSemantics(resultType);
     if (!semantics)
       return terminateStateOnExecError(state, "Unsupported UIToFP operation");
@@ -4155,7 +4414,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
     if (X86FPAsX87FP80 && Context::get().getPointerWidth() == 32) {
       resultType = Expr::Fl80;
     }
-    ref<Expr> arg = eval(ki, 0, state).value;
+    ref<Expr> arg = eval(ki, 0, state).value();
     const llvm::fltSemantics *semantics = fpWidthToSemantics(resultType);
     if (!semantics)
       return terminateStateOnExecError(state, "Unsupported SIToFP operation");
@@ -4166,8 +4425,8 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
 
   case Instruction::FCmp: {
     FCmpInst *fi = cast<FCmpInst>(i);
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
+    ref<Expr> left = eval(ki, 0, state).value();
+    ref<Expr> right = eval(ki, 1, state).value();
     if (!fpWidthToSemantics(left->getWidth()) ||
         !fpWidthToSemantics(right->getWidth()))
       return terminateStateOnExecError(state, "Unsupported FCmp operation");
@@ -4180,8 +4439,8 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   case Instruction::InsertValue: {
     KGEPInstruction *kgepi = static_cast<KGEPInstruction *>(ki);
 
-    ref<Expr> agg = eval(ki, 0, state).value;
-    ref<Expr> val = eval(ki, 1, state).value;
+    ref<Expr> agg = eval(ki, 0, state).value();
+    ref<Expr> val = eval(ki, 1, state).value();
 
     ref<Expr> l = NULL, r = NULL;
     unsigned lOffset = kgepi->offset * 8,
@@ -4208,7 +4467,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   case Instruction::ExtractValue: {
     KGEPInstruction *kgepi = static_cast<KGEPInstruction *>(ki);
 
-    ref<Expr> agg = eval(ki, 0, state).value;
+    ref<Expr> agg = eval(ki, 0, state).value();
 
     ref<Expr> result = ExtractExpr::create(agg, kgepi->offset * 8,
                                            getWidthForLLVMType(i->getType()));
@@ -4222,9 +4481,9 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   }
   case Instruction::InsertElement: {
     InsertElementInst *iei = cast<InsertElementInst>(i);
-    ref<Expr> vec = eval(ki, 0, state).value;
-    ref<Expr> newElt = eval(ki, 1, state).value;
-    ref<Expr> idx = eval(ki, 2, state).value;
+    ref<Expr> vec = eval(ki, 0, state).value();
+    ref<Expr> newElt = eval(ki, 1, state).value();
+    ref<Expr> idx = eval(ki, 2, state).value();
 
     ConstantExpr *cIdx = dyn_cast<ConstantExpr>(idx);
     if (cIdx == NULL) {
@@ -4266,8 +4525,8 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   }
   case Instruction::ExtractElement: {
     ExtractElementInst *eei = cast<ExtractElementInst>(i);
-    ref<Expr> vec = eval(ki, 0, state).value;
-    ref<Expr> idx = eval(ki, 1, state).value;
+    ref<Expr> vec = eval(ki, 0, state).value();
+    ref<Expr> idx = eval(ki, 1, state).value();
 
     ConstantExpr *cIdx = dyn_cast<ConstantExpr>(idx);
     if (cIdx == NULL) {
@@ -4315,7 +4574,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
       break;
     }
 
-    ref<Expr> arg = eval(ki, 0, state).value;
+    ref<Expr> arg = eval(ki, 0, state).value();
     ref<Expr> exceptionPointer = ExtractExpr::create(arg, 0, Expr::Int64);
     ref<Expr> selectorValue =
         ExtractExpr::create(arg, Expr::Int64, Expr::Int32)->getValue();
@@ -4470,19 +4729,30 @@ void Executor::bindInstructionConstants(KInstruction *KI) {
   }
 }
 
+void Executor::bindFunctionConstants(KFunction *kf,
+                                     llvm::APFloat::roundingMode rm) {
+  KInstruction **instructions = kf->getInstructions();
+  for (unsigned i = 0; i < kf->numInstructions; ++i)
+    bindInstructionConstants(instructions[i]);
+
+  // Evaluate the constants first referenced by this function
+  for (size_t i = kmodule->constantTable.size(); i < kmodule->constants.size();
+       ++i) {
+    kmodule->constantTable.emplace_back(
+        evalConstant(kmodule->constants[i], rm));
+  }
+}
+
 void Executor::bindModuleConstants(llvm::APFloat::roundingMode rm) {
   for (auto &kfp : kmodule->functions) {
-    KFunction *kf = kfp.get();
-    for (unsigned i = 0; i < kf->numInstructions; ++i)
-      bindInstructionConstants(kf->instructions[i]);
+    if (kfp->isMaterialized())
+      bindFunctionConstants(kfp.get(), rm);
   }
 
-  kmodule->constantTable =
-      std::unique_ptr<Cell[]>(new Cell[kmodule->constants.size()]);
-  for (unsigned i = 0; i < kmodule->constants.size(); ++i) {
-    Cell &c = kmodule->constantTable[i];
-    c.value = evalConstant(kmodule->constants[i], rm);
-  }
+  // Functions that are built later are bound on their first use
+  kmodule->onMaterialize = [this, rm](KFunction *kf) {
+    bindFunctionConstants(kf, rm);
+  };
 }
 
 bool Executor::checkMemoryUsage() {
@@ -4588,16 +4858,16 @@ void Executor::doDumpStates() {
 const KInstruction *Executor::getKInst(const llvm::Instruction *inst) const {
   const llvm::Function *caller = inst->getFunction();
   KFunction *kf = kmodule->functionMap.at(caller);
-  assert(kf && kf->instructionMap.find(inst) != kf->instructionMap.end());
-  return kf->instructionMap.at(inst);
+  assert(kf && kf->getInstructionMap().count(inst));
+  return kf->getInstructionMap().at(inst);
 }
 
 const KBlock *Executor::getKBlock(const llvm::BasicBlock *bb) const {
   const llvm::Function *F = bb->getParent();
   assert(F && kmodule->functionMap.find(F) != kmodule->functionMap.end());
   klee::KFunction *KF = kmodule->functionMap.at(F);
-  assert(KF->blockMap.find(bb) != KF->blockMap.end());
-  const klee::KBlock *KB = KF->blockMap.at(bb);
+  assert(KF->getBlockMap().count(bb));
+  const klee::KBlock *KB = KF->getBlockMap().at(bb);
   assert(KB);
   return KB;
 }
@@ -4777,6 +5047,7 @@ void Executor::run(ExecutionState *initialState) {
 
   doDumpStates();
 
+  mergingSearcher = nullptr;
   searcher = nullptr;
   targetManager = nullptr;
 
@@ -4867,6 +5138,8 @@ void Executor::goForward(ref<ForwardAction> action) {
   } else if (state.isSymbolicCycled(MaxSymbolicCycles)) {
     terminateStateEarly(state, "max-sym-cycles exceeded.",
                         StateTerminationType::MaxCycles);
+  } else if (mergingSearcher && reachedJoinPoint(state)) {
+    mergeOrPauseState(state);
   } else {
     maxNewWriteableOSSize = 0;
     maxNewStateStackSize = 0;
@@ -4888,6 +5161,54 @@ void Executor::goForward(ref<ForwardAction> action) {
   }
 }
 
+void Executor::addJoinPoint(ExecutionState &state, KBlock *branchBlock) {
+  KBlock *join = codeGraphInfo->getImmediatePostDominator(branchBlock);
+  if (!join) {
+    return;
+  }
+  // PHI nodes depend on the incoming block, so states join after them
+  unsigned index = 0;
+  while (index + 1 < join->getNumInstructions() &&
+         isa<PHINode>(join->instructions[index]->inst())) {
+    ++index;
+  }
+  auto point = std::make_pair(join->instructions[index], state.stack.size());
+  if (state.joinPoints.empty() || state.joinPoints.back() != point) {
+    state.joinPoints.push_back(point);
+  }
+}
+
+bool Executor::reachedJoinPoint(ExecutionState &state) {
+  auto &points = state.joinPoints;
+  // join points of frames that have already returned are unreachable
+  while (!points.empty() && points.back().second > state.stack.size()) {
+    points.pop_back();
+  }
+  auto point = std::make_pair(static_cast<KInstruction *>(state.pc),
+                              state.stack.size());
+  if (points.empty() || points.back() != point) {
+    return false;
+  }
+  while (!points.empty() && points.back() == point) {
+    points.pop_back();
+  }
+  return true;
+}
+
+void Executor::mergeOrPauseState(ExecutionState &state) {
+  for (const auto &paused : mergingSearcher->getPausedStates()) {
+    ExecutionState *partner = paused.first;
+    if (partner->pc == state.pc &&
+        partner->merge(state, StateMergingMaxSelects)) {
+      ++stats::mergedStates;
+      mergingSearcher->continueState(*partner);
+      terminateState(state, StateTerminationType::SilentExit);
+      return;
+    }
+  }
+  mergingSearcher->pauseState(state);
+}
+
 std::string Executor::getAddressInfo(ExecutionState &state,
                                      ref<PointerExpr> address, unsigned size,
                                      const MemoryObject *mo) const {
@@ -5164,7 +5485,7 @@ void Executor::terminateStateOnError(ExecutionState &state,
     if (!filepath.empty()) {
       msg << "File: " << filepath << '\n' << "Line: " << ki->getLine() << '\n';
       {
-        auto asmLine = ki->getKModule()->getAsmLine(ki->inst());
+        auto asmLine = ki->getKModule()->getAsmLine(ki);
         if (asmLine.has_value()) {
           msg << "assembly.ll line: " << asmLine.value() << '\n';
         }
@@ -5248,8 +5569,7 @@ void Executor::callExternalFunction(ExecutionState &state, KInstruction *target,
       return;
     }
 
-    if (specialFunctionHandler->handle(state, func->function(), target,
-                                       arguments))
+    if (specialFunctionHandler->handle(state, func, target, arguments))
       return;
   }
 
@@ -5275,6 +5595,7 @@ void Executor::callExternalFunction(ExecutionState &state, KInstruction *target,
   signature. Notice, that number of them can differ from passed,
   as function can have variadic arguments. */
   llvm::FunctionType *functionType = callable->getFunctionType();
+  std::vector<uint64_t> pointerArguments;
 
   if (arguments.size() > 0) {
     ref<SolverResponse> response;
@@ -5301,6 +5622,8 @@ void Executor::callExternalFunction(ExecutionState &state, KInstruction *target,
         ce->toMemory(&args[wordIndex]);
         addConstraint(state, EqExpr::create(ce, arg));
         wordIndex += (ce->getWidth() + 63) / 64;
+        if (ce->getWidth() == Context::get().getPointerWidth())
+          pointerArguments.push_back(ce->getZExtValue());
       } else {
         ref<Expr> arg = toUnique(state, *ai);
         if (ConstantExpr *ce = dyn_cast<ConstantExpr>(arg)) {
@@ -5311,12 +5634,15 @@ void Executor::callExternalFunction(ExecutionState &state, KInstruction *target,
           // XXX kick toMemory functions from here
           ce->toMemory(&args[wordIndex]);
           wordIndex += (ce->getWidth() + 63) / 64;
+          if (ce->getWidth() == Context::get().getPointerWidth())
+            pointerArguments.push_back(ce->getZExtValue());
         } else if (ConstantPointerExpr *cpe =
                        dyn_cast<ConstantPointerExpr>(arg)) {
           ref<ConstantExpr> ce = cpe->getConstantValue();
           // XXX kick toMemory functions from here
           ce->toMemory(&args[wordIndex]);
           wordIndex += (ce->getWidth() + 63) / 64;
+          pointerArguments.push_back(ce->getZExtValue());
         } else {
           terminateStateOnExecError(state,
                                     "external call with symbolic argument: " +
@@ -5336,7 +5662,13 @@ void Executor::callExternalFunction(ExecutionState &state, KInstruction *target,
   solver->getInitialValues(state.constraints.cs(), arrays, values,
                            state.queryMetaData);
   Assignment assignment(arrays, values);
-  state.addressSpace.copyOutConcretes(assignment);
+  std::vector<const MemoryObject *> syncedObjects;
+  if (ExternalCallsSyncReachable) {
+    state.addressSpace.copyOutReachableConcretes(pointerArguments, assignment,
+                                                 syncedObjects);
+  } else {
+    state.addressSpace.copyOutConcretes(assignment);
+  }
 #ifndef WINDOWS
   // Update external errno state with local state value
   ObjectPair result;
@@ -5410,7 +5742,9 @@ void Executor::callExternalFunction(ExecutionState &state, KInstruction *target,
     return;
   }
 
-  if (!state.addressSpace.copyInConcretes(assignment)) {
+  if (!(ExternalCallsSyncReachable
+            ? state.addressSpace.copyInConcretes(syncedObjects, assignment)
+            : state.addressSpace.copyInConcretes(assignment))) {
     terminateStateOnExecError(state, "external modified read-only object",
                               StateTerminationType::External);
     return;
@@ -5902,7 +6236,9 @@ MemoryObject *Executor::allocate(ExecutionState &state, ref<Expr> size,
     if (const auto inst =
             dyn_cast<const llvm::Instruction>(allocSite->source->unwrap())) {
       KInstruction *ki =
-          kmodule->getKBlock(inst->getParent())->parent->instructionMap[inst];
+          kmodule->getKBlock(inst->getParent())
+              ->parent->getInstructionMap()
+              .at(inst);
       sourceAddressArray = SourceBuilder::symbolicSizeConstantAddress(
           updateNameVersion(state, "const_arr"), ki, size);
     } else if (const auto global = dyn_cast<const llvm::GlobalVariable>(
@@ -6347,25 +6683,37 @@ void Executor::executeMemoryOperation(
 
   base = optimizer.optimizeExpr(base, true);
 
-  ref<Expr> isNullPointer = Expr::createIsZero(base);
-  StatePair branches = forkInternal(estate, isNullPointer, BranchType::MemOp);
-  ExecutionState *bound = branches.first;
-  if (bound) {
-    auto error = (isReadFromSymbolicArray(base) && branches.second)
-                     ? ReachWithError::MayBeNullPointerException
-                     : ReachWithError::MustBeNullPointerException;
-    terminateStateOnTargetError(*bound, error);
+  StatePair branches(nullptr, &estate);
+  if (isa<ConstantExpr>(base) ||
+      !estate.getResolutionCache().nonNullBases.count(base)) {
+    ref<Expr> isNullPointer = Expr::createIsZero(base);
+    branches = forkInternal(estate, isNullPointer, BranchType::MemOp);
+    ExecutionState *bound = branches.first;
+    if (bound) {
+      auto error = (isReadFromSymbolicArray(base) && branches.second)
+                       ? ReachWithError::MayBeNullPointerException
+                       : ReachWithError::MustBeNullPointerException;
+      terminateStateOnTargetError(*bound, error);
+    }
+    if (!branches.second)
+      return;
+    if (!isa<ConstantExpr>(base))
+      branches.second->getResolutionCache().addNonNullBase(base);
   }
-  if (!branches.second)
-    return;
   ExecutionState *state = branches.second;
 
   // fast path: single in-bounds resolution
   ref<const MemoryObject> idFastResult;
   bool success = false;
+  bool cachedInBounds = false;
 
-  if (state->resolvedPointers.count(base) &&
-      state->resolvedPointers.at(base).size() == 1) {
+  auto cachedResolution = state->getResolutionCache().inBounds.lookup(address);
+  if (cachedResolution && cachedResolution->second >= bytes) {
+    success = true;
+    cachedInBounds = true;
+    idFastResult = cachedResolution->first;
+  } else if (state->resolvedPointers.count(base) &&
+             state->resolvedPointers.at(base).size() == 1) {
     success = true;
     idFastResult = *state->resolvedPointers[base].begin();
   } else {
@@ -6392,30 +6740,40 @@ void Executor::executeMemoryOperation(
         state->addressSpace.findOrLazyInitializeObject(idFastResult.get());
     const MemoryObject *mo = op.first;
 
-    ref<ConstantExpr> sizeExpr = dyn_cast<ConstantExpr>(mo->getSizeExpr());
-    if (MaxSymArraySize && sizeExpr &&
-        sizeExpr->getZExtValue() >= MaxSymArraySize) {
-      base = toConstant(*state, base, "max-sym-array-size");
-    }
+    bool mustBeInBounds = cachedInBounds;
+    if (!cachedInBounds) {
+      bool concretized = false;
+      ref<ConstantExpr> sizeExpr = dyn_cast<ConstantExpr>(mo->getSizeExpr());
+      if (MaxSymArraySize && sizeExpr &&
+          sizeExpr->getZExtValue() >= MaxSymArraySize) {
+        base = toConstant(*state, base, "max-sym-array-size");
+        concretized = true;
+      }
 
-    ref<Expr> inBounds = mo->getBoundsCheckPointer(address, bytes);
+      ref<Expr> inBounds = mo->getBoundsCheckPointer(address, bytes);
 
-    inBounds = optimizer.optimizeExpr(inBounds, true);
-    inBounds = Simplificator::simplifyExpr(state->constraints.cs(), inBounds)
-                   .simplified;
+      inBounds = optimizer.optimizeExpr(inBounds, true);
+      inBounds = Simplificator::simplifyExpr(state->constraints.cs(), inBounds)
+                     .simplified;
 
-    ref<SolverResponse> response;
-    solver->setTimeout(coreSolverTimeout);
-    bool success = solver->getResponse(state->constraints.cs(), inBounds,
-                                       response, state->queryMetaData);
-    solver->setTimeout(time::Span());
-    if (!success) {
-      state->pc = state->prevPC;
-      terminateStateOnSolverError(*state, "Query timed out (bounds check).");
-      return;
+      ref<SolverResponse> response;
+      solver->setTimeout(coreSolverTimeout);
+      bool success = solver->getResponse(state->constraints.cs(), inBounds,
+                                         response, state->queryMetaData);
+      solver->setTimeout(time::Span());
+      if (!success) {
+        state->pc = state->prevPC;
+        terminateStateOnSolverError(*state, "Query timed out (bounds check).");
+        return;
+      }
+
+      mustBeInBounds = !isa<InvalidResponse>(response);
+      if (mustBeInBounds && !concretized &&
+          !isa<ConstantExpr>(address->getBase())) {
+        state->getResolutionCache().addInBounds(address, mo, bytes);
+      }
     }
 
-    bool mustBeInBounds = !isa<InvalidResponse>(response);
     if (mustBeInBounds) {
       ref<Expr> result;
       op = state->addressSpace.findOrLazyInitializeObject(idFastResult.get());
@@ -6782,7 +7140,7 @@ void Executor::lazyInitializeLocalObject(ExecutionState &state, StackFrame &sf,
       kmodule->targetData->getTypeStoreSize(ai->getAllocatedType());
   ref<Expr> size = Expr::createPointer(elementSize);
   if (ai->isArrayAllocation()) {
-    ref<Expr> count = eval(target, 0, state, sf).value;
+    ref<Expr> count = eval(target, 0, state, sf).value();
     count = Expr::createZExtToPointerWidth(count);
     size = MulExpr::create(size, count);
     if (isa<ConstantExpr>(size)) {
@@ -6928,7 +7286,7 @@ void Executor::executeMakeSymbolic(ExecutionState &state,
 
 ExecutionState *Executor::formState(Function *f) {
   ExecutionState *state = new ExecutionState(
-      kmodule->functionMap[f], kmodule->functionMap[f]->blockMap[&*f->begin()]);
+      kmodule->functionMap[f], kmodule->functionMap[f]->getEntryKBlock());
   initializeGlobals(*state);
   return state;
 }
@@ -7087,7 +7445,7 @@ void Executor::runFunctionAsMain(Function *f, int argc, char **argv,
         klee_warning("%s was eliminated by LLVM passes, so it is unreachable",
                      FunctionCallReproduce.c_str());
       } else {
-        auto kCallBlock = kfIt->second->entryKBlock;
+        auto kCallBlock = kfIt->second->getEntryKBlock();
         forest = new TargetForest(kEntryFunction);
         forest->add(ReproduceErrorTarget::create(
             {ReachWithError::Reachable}, "",
@@ -160,6 +160,8 @@ private:
   std::unique_ptr<PForest> processForest;
   GuidanceKind guidanceKind;
   std::unique_ptr<CodeGraphInfo> codeGraphInfo;
+  /// Non-null iff --use-state-merging is enabled; owned by the searcher
+  MergingSearcher *mergingSearcher = nullptr;
   std::unique_ptr<DistanceCalculator> distanceCalculator;
   std::unique_ptr<TargetCalculator> targetCalculator;
   std::unique_ptr<TargetManager> targetManager;
@@ -263,11 +265,42 @@ private:
 
   void executeInstruction(ExecutionState &state, KInstruction *ki);
 
+  /// Fast path of executeInstruction for integer arithmetic and comparisons
+  /// over concrete operands of at most 64 bits: the result is stored unboxed
+  /// in the destination register. Returns false if the instruction has to
+  /// take the generic path.
+  bool executeConcreteInstruction(ExecutionState &state, KInstruction *ki);
+
+  /// Concrete arguments of a call to a summarizable function, see
+  /// isSummarizable(): value and width of each formal argument.
+  using CallSummaryKey =
+      std::pair<const KFunction *,
+                std::vector<std::pair<std::uint64_t, Expr::Width>>>;
+
+  /// Results of earlier calls to summarizable functions.
+  std::map<CallSummaryKey, ref<Expr>> callSummaries;
+
+  /// Returns true if calls to kf with concrete arguments may reuse the
+  /// result of an earlier call: it is a runtime function that does not
+  /// access memory and returns an integer.
+  bool isSummarizable(const KFunction *kf) const;
+
   void seed(ExecutionState &initialState);
   void run(ExecutionState *initialState);
 
   void initializeTypeManager();
 
+  /// Link the user, library, intrinsic and (if requested) mock modules
+  /// into kmodule and instrument them.
+  void
+  linkModules(std::vector<std::unique_ptr<llvm::Module>> &userModules,
+              std::vector<std::unique_ptr<llvm::Module>> &libsModules,
+              const std::string &intrinsicsPath, const ModuleOptions &opts,
+              bool useMocks, std::set<std::string> &mainModuleFunctions,
+              std::set<std::string> &mainModuleGlobals,
+              const std::set<std::string> &ignoredExternals,
+              std::vector<std::pair<std::string, std::string>> &redefinitions);
+
   // Given a concrete object in our [klee's] address space, add it to
   // objects checked code can reference.
   MemoryObject *addExternalObject(ExecutionState &state, void *addr, KType *,
@@ -470,21 +503,19 @@ private:
 
   ref<Expr> readArgument(ExecutionState &state, StackFrame &frame,
                          const KFunction *kf, unsigned index) {
-    ref<Expr> arg = frame.locals->at(kf->getArgRegister(index)).value;
-    if (!arg) {
+    if (frame.locals->at(kf->getArgRegister(index)).isNull()) {
       prepareSymbolicArg(state, frame, index);
     }
-    return frame.locals->at(kf->getArgRegister(index)).value;
+    return frame.locals->at(kf->getArgRegister(index)).value();
   }
 
   ref<Expr> readDest(ExecutionState &state, StackFrame &frame,
                      const KInstruction *target) {
     unsigned index = target->getDest();
-    ref<Expr> reg = frame.locals->at(index).value;
-    if (!reg) {
+    if (frame.locals->at(index).isNull()) {
       prepareSymbolicRegister(state, frame, index);
     }
-    return frame.locals->at(index).value;
+    return frame.locals->at(index).value();
   }
 
   const Cell &getArgumentCell(const StackFrame &frame, const KFunction *kf,
@@ -506,6 +537,11 @@ private:
     return frame.locals->set(target->getDest(), Cell(value));
   }
 
+  void setDestCell(StackFrame &frame, const KInstruction *target,
+                   const Cell &value) {
+    return frame.locals->set(target->getDest(), value);
+  }
+
   const Cell &eval(const KInstruction *ki, unsigned index,
                    ExecutionState &state, bool isSymbolic = true);
 
@@ -529,6 +565,11 @@ private:
     setDestCell(state.stack.valueStack().back(), target, value);
   }
 
+  void setDestCell(ExecutionState &state, const KInstruction *target,
+                   const Cell &value) {
+    setDestCell(state.stack.valueStack().back(), target, value);
+  }
+
   void bindLocal(const KInstruction *target, StackFrame &frame,
                  ref<Expr> value);
 
@@ -669,6 +710,10 @@ private:
   /// bindModuleConstants - Initialize the module constant table.
   void bindModuleConstants(llvm::APFloat::roundingMode rm);
 
+  /// Bind the instruction constants of kf and extend the module constant
+  /// table by the constants it introduced.
+  void bindFunctionConstants(KFunction *kf, llvm::APFloat::roundingMode rm);
+
   uint64_t updateNameVersion(ExecutionState &state, const std::string &name);
 
   const Array *makeArray(ref<Expr> size,
@@ -720,6 +765,14 @@ private:
   void executeAction(ref<SearcherAction> action);
   void goForward(ref<ForwardAction> action);
 
+  /// Records the join point of a symbolic branch taken in `branchBlock`
+  void addJoinPoint(ExecutionState &state, KBlock *branchBlock);
+  /// Pops the join points of `state` reached at its current instruction
+  bool reachedJoinPoint(ExecutionState &state);
+  /// Merges `state` into a paused state waiting at the same join point or
+  /// pauses it until a merge partner arrives
+  void mergeOrPauseState(ExecutionState &state);
+
   const KInstruction *getKInst(const llvm::Instruction *ints) const;
   const KBlock *getKBlock(const llvm::BasicBlock *bb) const;
   const KFunction *getKFunction(const llvm::Function *f) const;
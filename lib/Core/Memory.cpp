@@ -62,6 +62,21 @@ llvm::cl::opt<unsigned long> MaxFixedSizeStructureSize(
     llvm::cl::desc("Maximum available size to use dense structures for memory "
                    "(default 10Mb)"),
     llvm::cl::init(10ll << 10));
+
+llvm::cl::opt<unsigned> MaxDenseConcreteSize(
+    "max-dense-concrete-size",
+    llvm::cl::desc("Maximum size of an object whose concrete contents are kept "
+                   "as a plain byte array until a symbolic byte is written. "
+                   "Set to 0 to disable (default 4096)"),
+    llvm::cl::init(4096));
+
+llvm::cl::opt<unsigned> UpdateListCompactionThreshold(
+    "update-list-compaction-threshold",
+    llvm::cl::desc("Fold the concrete-index writes of an object into a new "
+                   "constant array once this many updates have accumulated "
+                   "since the last compaction. Set to 0 to disable "
+                   "(default 256)"),
+    llvm::cl::init(256));
 } // namespace klee
 
 using namespace llvm;
@@ -127,17 +142,29 @@ ObjectState::ObjectState(const MemoryObject *mo, KType *dt)
 ObjectState::ObjectState(const ObjectState &os)
     : copyOnWriteOwner(0), object(os.object), valueOS(os.valueOS),
       baseOS(os.baseOS), lastUpdate(os.lastUpdate), size(os.size),
-      dynamicType(os.dynamicType), readOnly(os.readOnly),
-      wasWritten(os.wasWritten) {}
+      dynamicType(os.dynamicType), pendingContents(os.pendingContents),
+      readOnly(os.readOnly), wasWritten(os.wasWritten) {}
 
 /***/
 
+void ObjectState::materializePendingContents() const {
+  llvm::StringRef contents = pendingContents;
+  pendingContents = llvm::StringRef();
+  // Materializing does not change the observable contents of the object, so
+  // it is done in place even when the state is shared.
+  ObjectState *self = const_cast<ObjectState *>(this);
+  for (unsigned i = 0, e = contents.size(); i != e; ++i)
+    self->write8(i, static_cast<uint8_t>(contents[i]));
+}
+
 void ObjectState::initializeToZero() {
+  pendingContents = llvm::StringRef();
   valueOS.initializeToZero();
   baseOS.initializeToZero();
 }
 
 ref<Expr> ObjectState::read8(unsigned offset) const {
+  materialize();
   ref<Expr> val = valueOS.readWidth(offset);
   ref<Expr> base = baseOS.readWidth(offset);
   if (base->isZero()) {
@@ -148,14 +175,17 @@ ref<Expr> ObjectState::read8(unsigned offset) const {
 }
 
 ref<Expr> ObjectState::readValue8(unsigned offset) const {
+  materialize();
   return valueOS.readWidth(offset);
 }
 
 ref<Expr> ObjectState::readBase8(unsigned offset) const {
+  materialize();
   return baseOS.readWidth(offset);
 }
 
 ref<Expr> ObjectState::read8(ref<Expr> offset) const {
+  materialize();
   assert(!isa<ConstantExpr>(offset) &&
          "constant offset passed to symbolic read8");
 
@@ -185,6 +215,7 @@ ref<Expr> ObjectState::read8(ref<Expr> offset) const {
 }
 
 ref<Expr> ObjectState::readValue8(ref<Expr> offset) const {
+  materialize();
   assert(!isa<ConstantExpr>(offset) &&
          "constant offset passed to symbolic read8");
 
@@ -208,6 +239,7 @@ ref<Expr> ObjectState::readValue8(ref<Expr> offset) const {
 }
 
 ref<Expr> ObjectState::readBase8(ref<Expr> offset) const {
+  materialize();
   assert(!isa<ConstantExpr>(offset) &&
          "constant offset passed to symbolic read8");
 
@@ -230,13 +262,25 @@ ref<Expr> ObjectState::readBase8(ref<Expr> offset) const {
   return baseOS.readWidth(offset);
 }
 
+bool ObjectState::writeConcrete(unsigned offset, uint64_t value,
+                                unsigned bytes) {
+  materialize();
+  if (!valueOS.isDenseConcrete() || !baseOS.isKnownZero())
+    return false;
+  valueOS.writeConcrete(offset, value, bytes);
+  return true;
+}
+
 void ObjectState::write8(unsigned offset, uint8_t value) {
+  if (writeConcrete(offset, value, 1))
+    return;
   valueOS.writeWidth(offset, value);
   baseOS.writeWidth(offset,
                     ConstantExpr::create(0, Context::get().getPointerWidth()));
 }
 
 void ObjectState::write8(unsigned offset, ref<Expr> value) {
+  materialize();
   wasWritten = true;
   if (auto pointer = dyn_cast<PointerExpr>(value)) {
     valueOS.writeWidth(offset, pointer->getValue());
@@ -248,7 +292,44 @@ void ObjectState::write8(unsigned offset, ref<Expr> value) {
   }
 }
 
+unsigned ObjectState::countDifferentBytes(const ObjectState &other) const {
+  materialize();
+  other.materialize();
+  assert(object == other.object && "merging different objects");
+  auto moSize = cast<ConstantExpr>(object->getSizeExpr())->getZExtValue();
+  unsigned count = 0;
+  for (unsigned i = 0; i < moSize; i++) {
+    if (valueOS.readWidth(i) != other.valueOS.readWidth(i) ||
+        baseOS.readWidth(i) != other.baseOS.readWidth(i)) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+void ObjectState::merge(ref<Expr> condition, const ObjectState &other) {
+  materialize();
+  other.materialize();
+  assert(object == other.object && "merging different objects");
+  auto moSize = cast<ConstantExpr>(object->getSizeExpr())->getZExtValue();
+  for (unsigned i = 0; i < moSize; i++) {
+    ref<Expr> value = valueOS.readWidth(i);
+    ref<Expr> otherValue = other.valueOS.readWidth(i);
+    if (value != otherValue) {
+      valueOS.writeWidth(i, SelectExpr::create(condition, value, otherValue));
+      wasWritten = true;
+    }
+    ref<Expr> base = baseOS.readWidth(i);
+    ref<Expr> otherBase = other.baseOS.readWidth(i);
+    if (base != otherBase) {
+      baseOS.writeWidth(i, SelectExpr::create(condition, base, otherBase));
+      wasWritten = true;
+    }
+  }
+}
+
 void ObjectState::write8(ref<Expr> offset, ref<Expr> value) {
+  materialize();
   wasWritten = true;
 
   assert(!isa<ConstantExpr>(offset) &&
@@ -280,6 +361,8 @@ void ObjectState::write8(ref<Expr> offset, ref<Expr> value) {
 }
 
 void ObjectState::write(ref<const ObjectState> os) {
+  materialize();
+  os->materialize();
   wasWritten = true;
   valueOS.write(os->valueOS);
   baseOS.write(os->baseOS);
@@ -293,6 +376,10 @@ ref<Expr> ObjectState::read(ref<Expr> offset, Expr::Width width) const {
       lastUpdate->value->getWidth() == width)
     return lastUpdate->value;
 
+  // Reads at constant offsets are truncated to 32 bits like in readValue
+  if (ConstantExpr *CE = dyn_cast<ConstantExpr>(offset))
+    return read(static_cast<unsigned>(CE->getZExtValue()), width);
+
   ref<Expr> val = readValue(offset, width);
   ref<Expr> base = readBase(offset, width);
   if (base->isZero()) {
@@ -303,6 +390,12 @@ ref<Expr> ObjectState::read(ref<Expr> offset, Expr::Width width) const {
 }
 
 ref<Expr> ObjectState::read(unsigned offset, Expr::Width width) const {
+  materialize();
+  if (width != Expr::Bool && width <= Expr::Int64 && width % 8 == 0 &&
+      valueOS.isDenseConcrete() && baseOS.isKnownZero()) {
+    return ConstantExpr::create(valueOS.readConcrete(offset, width / 8), width);
+  }
+
   ref<Expr> val = readValue(offset, width);
   ref<Expr> base = readBase(offset, width);
   if (base->isZero()) {
@@ -487,6 +580,8 @@ void ObjectState::write(unsigned offset, ref<Expr> value) {
 }
 
 void ObjectState::write16(unsigned offset, uint16_t value) {
+  if (writeConcrete(offset, value, 2))
+    return;
   unsigned NumBytes = 2;
   for (unsigned i = 0; i != NumBytes; ++i) {
     unsigned idx = Context::get().isLittleEndian() ? i : (NumBytes - i - 1);
@@ -495,6 +590,8 @@ void ObjectState::write16(unsigned offset, uint16_t value) {
 }
 
 void ObjectState::write32(unsigned offset, uint32_t value) {
+  if (writeConcrete(offset, value, 4))
+    return;
   unsigned NumBytes = 4;
   for (unsigned i = 0; i != NumBytes; ++i) {
     unsigned idx = Context::get().isLittleEndian() ? i : (NumBytes - i - 1);
@@ -503,6 +600,8 @@ void ObjectState::write32(unsigned offset, uint32_t value) {
 }
 
 void ObjectState::write64(unsigned offset, uint64_t value) {
+  if (writeConcrete(offset, value, 8))
+    return;
   unsigned NumBytes = 8;
   for (unsigned i = 0; i != NumBytes; ++i) {
     unsigned idx = Context::get().isLittleEndian() ? i : (NumBytes - i - 1);
@@ -511,6 +610,7 @@ void ObjectState::write64(unsigned offset, uint64_t value) {
 }
 
 void ObjectState::print() const {
+  materialize();
   llvm::errs() << "-- ObjectState --\n";
   llvm::errs() << "\tBase ObjectStage:\n";
   valueOS.print();
@@ -539,19 +639,33 @@ ObjectStage::ObjectStage(const Array *array, ref<Expr> defaultValue, bool safe,
 ObjectStage::ObjectStage(ref<Expr> size, ref<Expr> defaultValue, bool safe,
                          Expr::Width width)
     : updates(nullptr, nullptr), size(size), safeRead(safe), width(width) {
+  // Without a default value unwritten bytes read as zero, so small byte-wide
+  // stages start out dense
+  auto constSize = dyn_cast<ConstantExpr>(size);
+  if (!defaultValue && width == Expr::Int8 && constSize &&
+      constSize->getZExtValue() != 0 &&
+      constSize->getZExtValue() <= MaxDenseConcreteSize) {
+    concreteBytes.assign(constSize->getZExtValue(), 0);
+    dense = true;
+    return;
+  }
   knownSymbolics.reset(constructStorage<ref<Expr>, OptionalRefEq<Expr>>(
       size, defaultValue, MaxFixedSizeStructureSize));
   unflushedMask.reset(constructStorage(size, false, MaxFixedSizeStructureSize));
 }
 
 ObjectStage::ObjectStage(const ObjectStage &os)
-    : knownSymbolics(os.knownSymbolics->clone()),
-      unflushedMask(os.unflushedMask->clone()), updates(os.updates),
-      size(os.size), safeRead(os.safeRead), width(os.width) {}
+    : knownSymbolics(os.dense ? nullptr : os.knownSymbolics->clone()),
+      unflushedMask(os.dense ? nullptr : os.unflushedMask->clone()),
+      updates(os.updates), compactedUpdates(os.compactedUpdates),
+      size(os.size), safeRead(os.safeRead),
+      width(os.width), concreteBytes(os.concreteBytes), dense(os.dense) {}
 
 /***/
 
 const UpdateList &ObjectStage::getUpdates() const {
+  assert(!dense && "dense stages have no update list");
+
   if (auto sizeExpr = dyn_cast<ConstantExpr>(size)) {
     auto size = sizeExpr->getZExtValue();
     if (knownSymbolics->storage().size() == size) {
@@ -591,17 +705,47 @@ const UpdateList &ObjectStage::getUpdates() const {
 }
 
 void ObjectStage::initializeToZero() {
+  if (dense) {
+    std::fill(concreteBytes.begin(), concreteBytes.end(), 0);
+    return;
+  }
   auto array = Array::create(
       size,
       SourceBuilder::constant(constructStorage(
           size, ConstantExpr::create(0, width), MaxFixedSizeStructureSize)),
       Expr::Int32, width);
   updates = UpdateList(array, nullptr);
+  compactedUpdates = 0;
   knownSymbolics->reset();
   unflushedMask->reset();
 }
 
+void ObjectStage::makeSparse() const {
+  if (!dense)
+    return;
+  std::unique_ptr<SparseStorage<ref<ConstantExpr>>> values(constructStorage(
+      size, ConstantExpr::create(0, width), MaxFixedSizeStructureSize));
+  for (unsigned i = 0, e = concreteBytes.size(); i != e; ++i) {
+    if (concreteBytes[i])
+      values->store(i, ConstantExpr::create(concreteBytes[i], width));
+  }
+  auto array = Array::create(size, SourceBuilder::constant(values.release()),
+                             Expr::Int32, width);
+  updates = UpdateList(array, nullptr);
+  compactedUpdates = 0;
+
+  // The constant array holds the bytes, so reads of bytes that are not
+  // written later fold to constants without caching them here
+  knownSymbolics.reset(constructStorage<ref<Expr>, OptionalRefEq<Expr>>(
+      size, nullptr, MaxFixedSizeStructureSize));
+  unflushedMask.reset(constructStorage(size, false, MaxFixedSizeStructureSize));
+  concreteBytes = std::vector<uint8_t>();
+  dense = false;
+}
+
 void ObjectStage::flushForRead() const {
+  if (dense)
+    return;
   for (const auto &unflushed : unflushedMask->storage()) {
     auto offset = unflushed.first;
     auto value = knownSymbolics->load(offset);
@@ -609,6 +753,12 @@ void ObjectStage::flushForRead() const {
     updates.extend(ConstantExpr::create(offset, Expr::Int32), value);
   }
   unflushedMask->reset(false);
+
+  if (UpdateListCompactionThreshold &&
+      updates.getSize() >= compactedUpdates + UpdateListCompactionThreshold) {
+    updates.compact();
+    compactedUpdates = updates.getSize();
+  }
 }
 
 void ObjectStage::flushForWrite() {
@@ -620,6 +770,10 @@ void ObjectStage::flushForWrite() {
 /***/
 
 ref<Expr> ObjectStage::readWidth(unsigned offset) const {
+  if (dense) {
+    assert(offset < concreteBytes.size() && "read out of bounds");
+    return ConstantExpr::create(concreteBytes[offset], width);
+  }
   if (auto byte = knownSymbolics->load(offset)) {
     return byte;
   } else {
@@ -633,13 +787,52 @@ ref<Expr> ObjectStage::readWidth(unsigned offset) const {
 ref<Expr> ObjectStage::readWidth(ref<Expr> offset) const {
   assert(!isa<ConstantExpr>(offset) &&
          "constant offset passed to symbolic read8");
+  // A symbolic read needs the contents as an array. Staying dense would
+  // rebuild that array after every concrete write, so switch for good.
+  makeSparse();
   flushForRead();
 
   return ReadExpr::create(getUpdates(), ZExtExpr::create(offset, Expr::Int32),
                           safeRead);
 }
 
+uint64_t ObjectStage::readConcrete(unsigned offset, unsigned bytes) const {
+  assert(dense && offset + bytes <= concreteBytes.size() &&
+         "invalid dense concrete read");
+  uint64_t value = 0;
+  for (unsigned i = 0; i != bytes; ++i) {
+    unsigned idx = Context::get().isLittleEndian() ? i : (bytes - i - 1);
+    value |= uint64_t(concreteBytes[offset + idx]) << (8 * i);
+  }
+  return value;
+}
+
+void ObjectStage::writeConcrete(unsigned offset, uint64_t value,
+                                unsigned bytes) {
+  assert(dense && offset + bytes <= concreteBytes.size() &&
+         "invalid dense concrete write");
+  for (unsigned i = 0; i != bytes; ++i) {
+    unsigned idx = Context::get().isLittleEndian() ? i : (bytes - i - 1);
+    concreteBytes[offset + idx] = static_cast<uint8_t>(value >> (8 * i));
+  }
+}
+
+bool ObjectStage::isKnownZero() const {
+  if (dense) {
+    return std::all_of(concreteBytes.begin(), concreteBytes.end(),
+                       [](uint8_t byte) { return byte == 0; });
+  }
+  const ref<Expr> &defaultValue = knownSymbolics->defaultV();
+  return defaultValue && defaultValue->isZero() &&
+         knownSymbolics->storage().size() == 0;
+}
+
 void ObjectStage::writeWidth(unsigned offset, uint64_t value) {
+  if (dense) {
+    assert(offset < concreteBytes.size() && "write out of bounds");
+    concreteBytes[offset] = static_cast<uint8_t>(value);
+    return;
+  }
   auto byte = knownSymbolics->load(offset);
   if (byte) {
     auto ce = dyn_cast<ConstantExpr>(byte);
@@ -656,6 +849,7 @@ void ObjectStage::writeWidth(unsigned offset, ref<Expr> value) {
   if (ConstantExpr *CE = dyn_cast<ConstantExpr>(value)) {
     writeWidth(offset, CE->getZExtValue(width));
   } else {
+    makeSparse();
     auto byte = knownSymbolics->load(offset);
     if (byte && byte == value) {
       return;
@@ -669,6 +863,7 @@ void ObjectStage::writeWidth(ref<Expr> offset, ref<Expr> value) {
   assert(!isa<ConstantExpr>(offset) &&
          "constant offset passed to symbolic write8");
 
+  makeSparse();
   if (knownSymbolics->defaultV() && knownSymbolics->defaultV() == value &&
       knownSymbolics->storage().size() == 0 && updates.getSize() == 0) {
     return;
@@ -680,6 +875,15 @@ void ObjectStage::writeWidth(ref<Expr> offset, ref<Expr> value) {
 }
 
 void ObjectStage::write(const ObjectStage &os) {
+  if (os.dense) {
+    size_t bound = os.concreteBytes.size();
+    if (auto constSize = dyn_cast<ConstantExpr>(size))
+      bound = std::min<size_t>(bound, constSize->getZExtValue());
+    for (size_t i = 0; i < bound; ++i)
+      writeWidth(i, os.concreteBytes[i]);
+    return;
+  }
+  makeSparse();
   auto constSize = dyn_cast<ConstantExpr>(size);
   auto osConstSize = dyn_cast<ConstantExpr>(os.size);
   if (constSize || osConstSize) {
@@ -711,6 +915,14 @@ void ObjectStage::print() const {
 
   llvm::errs() << "\tBytes:\n";
 
+  if (dense) {
+    for (size_t i = 0; i < concreteBytes.size(); ++i) {
+      llvm::errs() << "\t\t[" << i << "]" << unsigned(concreteBytes[i])
+                   << "\n";
+    }
+    return;
+  }
+
   for (auto [index, value] : knownSymbolics->storage()) {
     llvm::errs() << "\t\t[" << index << "]";
     llvm::errs() << value << "\n";
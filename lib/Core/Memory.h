@@ -236,11 +236,21 @@ private:
 
   // mutable because we may need flush during read of const
   mutable UpdateList updates;
+  /// Length of `updates` after its last compaction attempt
+  mutable unsigned compactedUpdates = 0;
 
   ref<Expr> size;
   bool safeRead;
   Expr::Width width;
 
+  /// Contents of a small byte-wide stage all of whose bytes are known
+  /// constants. While `dense` is set these bytes are authoritative and
+  /// neither the sparse storages nor `updates` are used. The first symbolic
+  /// write or read switches to the sparse representation for good; mutable
+  /// because that may happen during a read of a const stage.
+  mutable std::vector<uint8_t> concreteBytes;
+  mutable bool dense = false;
+
 public:
   ObjectStage(const Array *array, ref<Expr> defaultValue, bool safe = true,
               Expr::Width width = Expr::Int8);
@@ -262,7 +272,18 @@ public:
   void writeWidth(unsigned offset, uint64_t value);
   void print() const;
 
+  /// True while all bytes are held in the dense concrete representation.
+  bool isDenseConcrete() const { return dense; }
+  /// Reads `bytes` consecutive bytes of a dense concrete stage.
+  uint64_t readConcrete(unsigned offset, unsigned bytes) const;
+  /// Writes `bytes` consecutive bytes of a dense concrete stage.
+  void writeConcrete(unsigned offset, uint64_t value, unsigned bytes);
+  /// True if a read at any constant offset yields zero.
+  bool isKnownZero() const;
+
   size_t getSparseStorageEntries() {
+    if (dense)
+      return concreteBytes.size();
     return knownSymbolics->storage().size() + unflushedMask->storage().size();
   }
   void initializeToZero();
@@ -270,6 +291,9 @@ public:
 private:
   const UpdateList &getUpdates() const;
 
+  /// Switch from the dense concrete representation to the sparse one.
+  void makeSparse() const;
+
   void makeConcrete();
 
   void flushForRead() const;
@@ -298,6 +322,10 @@ private:
 
   KType *dynamicType;
 
+  /// Initial contents that have not been written into the stages yet. They
+  /// are materialized on the first access to the object.
+  mutable llvm::StringRef pendingContents;
+
 public:
   bool readOnly;
   bool wasWritten = false;
@@ -317,7 +345,16 @@ public:
   void setReadOnly(bool ro) { readOnly = ro; }
   void initializeToZero();
 
+  /// Defer writing the concrete initial `contents` of the object until it is
+  /// first accessed. The bytes must outlive the object state.
+  void setPendingContents(llvm::StringRef contents) {
+    pendingContents = contents;
+  }
+  /// Initial contents that are still pending, or empty if materialized.
+  llvm::StringRef getPendingContents() const { return pendingContents; }
+
   size_t getSparseStorageEntries() {
+    materialize();
     return valueOS.getSparseStorageEntries() + baseOS.getSparseStorageEntries();
   }
 
@@ -343,11 +380,27 @@ public:
   void write64(unsigned offset, uint64_t value);
   void print() const;
 
+  /// Number of bytes (value or base) that differ from `other`. Both objects
+  /// must be bound to the same memory object of constant size.
+  unsigned countDifferentBytes(const ObjectState &other) const;
+  /// Replace every byte that differs from `other` with
+  /// `select(condition, this, other)`.
+  void merge(ref<Expr> condition, const ObjectState &other);
+
   bool isAccessableFrom(KType *) const;
 
   KType *getDynamicType() const;
 
 private:
+  void materialize() const {
+    if (!pendingContents.empty())
+      materializePendingContents();
+  }
+  void materializePendingContents() const;
+  /// Writes `bytes` concrete bytes without creating expressions if the
+  /// object is dense and holds no pointers. Returns false otherwise.
+  bool writeConcrete(unsigned offset, uint64_t value, unsigned bytes);
+
   ref<Expr> read8(ref<Expr> offset) const;
   ref<Expr> readValue8(ref<Expr> offset) const;
   ref<Expr> readBase8(ref<Expr> offset) const;
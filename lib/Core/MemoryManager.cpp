@@ -53,6 +53,13 @@ llvm::cl::opt<unsigned> DeterministicAllocationSize(
         "Preallocated memory for deterministic allocation in MB (default=100)"),
     llvm::cl::init(100), llvm::cl::cat(MemoryCat));
 
+llvm::cl::opt<unsigned> DeterministicQuarantineSize(
+    "allocate-determ-quarantine",
+    llvm::cl::desc("Number of freed deterministic allocations that are kept "
+                   "in quarantine before their addresses are reused "
+                   "(default=1024)"),
+    llvm::cl::init(1024), llvm::cl::cat(MemoryCat));
+
 llvm::cl::opt<bool> NullOnZeroMalloc(
     "return-null-on-zero-malloc",
     llvm::cl::desc("Returns NULL if malloc(0) is called (default=false)"),
@@ -158,26 +165,22 @@ MemoryObject *MemoryManager::allocate(ref<Expr> size, bool isLocal,
   }
 
   uint64_t address = 0;
+  uint64_t slotSize = 0;
   if (!addressExpr) {
     ref<ConstantExpr> sizeExpr = dyn_cast<ConstantExpr>(size);
     assert(sizeExpr);
     auto moSize = sizeExpr->getZExtValue();
     if (DeterministicAllocation) {
-      address =
-          llvm::alignTo((uint64_t)nextFreeSlot + alignment - 1, alignment);
-
       // Handle the case of 0-sized allocations as 1-byte allocations.
       // This way, we make sure we have this allocation between its own red
       // zones
-      size_t alloc_size = std::max(moSize, (uint64_t)1);
-      if ((char *)address + alloc_size < deterministicSpace + spaceSize) {
-        nextFreeSlot = (char *)address + alloc_size + RedzoneSize;
-      } else {
+      address = allocateDeterministic(std::max(moSize, (uint64_t)1),
+                                      alignment, slotSize);
+      if (!address) {
         klee_warning_once(0,
                           "Couldn't allocate %" PRIu64
                           " bytes. Not enough deterministic space left.",
                           moSize);
-        address = 0;
       }
     } else {
       // Use malloc for the standard case
@@ -205,9 +208,54 @@ MemoryObject *MemoryManager::allocate(ref<Expr> size, bool isLocal,
                          conditionExpr, timestamp, content);
 
   objects.insert(res);
+  if (slotSize)
+    deterministicSlots[res] = {address, slotSize};
   return res;
 }
 
+uint64_t MemoryManager::allocateDeterministic(uint64_t size, size_t alignment,
+                                              uint64_t &slotSize) {
+  // Small slots use power-of-two classes, larger ones are rounded to pages
+  const uint64_t pageSize = 4096;
+  slotSize = size + RedzoneSize;
+  slotSize = slotSize <= pageSize ? llvm::PowerOf2Ceil(std::max<uint64_t>(
+                                        slotSize, 16))
+                                  : llvm::alignTo(slotSize, pageSize);
+
+  auto freeList = freeSlots.find(slotSize);
+  if (freeList != freeSlots.end() && !freeList->second.empty() &&
+      freeList->second.back() % alignment == 0) {
+    uint64_t address = freeList->second.back();
+    freeList->second.pop_back();
+    usedDeterministicSize += slotSize;
+    return address;
+  }
+
+  uint64_t address = llvm::alignTo((uint64_t)nextFreeSlot, alignment);
+  if ((char *)address + slotSize >= deterministicSpace + spaceSize) {
+    slotSize = 0;
+    return 0;
+  }
+  nextFreeSlot = (char *)address + slotSize;
+  usedDeterministicSize += slotSize;
+  return address;
+}
+
+void MemoryManager::releaseDeterministic(const MemoryObject *mo) {
+  auto it = deterministicSlots.find(mo);
+  if (it == deterministicSlots.end())
+    return;
+  quarantine.push_back(it->second);
+  deterministicSlots.erase(it);
+
+  while (quarantine.size() > DeterministicQuarantineSize) {
+    const DeterministicSlot &slot = quarantine.front();
+    freeSlots[slot.size].push_back(slot.address);
+    usedDeterministicSize -= slot.size;
+    quarantine.pop_front();
+  }
+}
+
 MemoryObject *MemoryManager::allocateFixed(uint64_t address, uint64_t size,
                                            ref<CodeLocation> allocSite,
                                            KType *type) {
@@ -247,10 +295,12 @@ void MemoryManager::markFreed(MemoryObject *mo) {
         free((void *)arrayConstantAddress->getZExtValue());
       }
     }
+    if (DeterministicAllocation)
+      releaseDeterministic(mo);
     objects.erase(mo);
   }
 }
 
 size_t MemoryManager::getUsedDeterministicSize() {
-  return nextFreeSlot - deterministicSpace;
+  return usedDeterministicSize;
 }
@@ -14,7 +14,11 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <deque>
+#include <map>
 #include <set>
+#include <unordered_map>
+#include <vector>
 
 namespace llvm {
 class Value;
@@ -36,6 +40,25 @@ private:
   char *nextFreeSlot;
   size_t spaceSize;
 
+  /// Deterministic allocations are served from slots of fixed size classes.
+  /// A slot is recycled once its memory object is released by all states:
+  /// it first waits in a FIFO quarantine, so that dangling pointers do not
+  /// immediately alias a new object, and then joins the free list of its
+  /// class. Reuse only depends on the order of allocations and frees, so
+  /// addresses stay reproducible across runs.
+  struct DeterministicSlot {
+    uint64_t address;
+    uint64_t size;
+  };
+  std::unordered_map<const MemoryObject *, DeterministicSlot> deterministicSlots;
+  std::deque<DeterministicSlot> quarantine;
+  std::map<uint64_t, std::vector<uint64_t>> freeSlots;
+  size_t usedDeterministicSize = 0;
+
+  uint64_t allocateDeterministic(uint64_t size, size_t alignment,
+                                 uint64_t &slotSize);
+  void releaseDeterministic(const MemoryObject *mo);
+
 public:
   MemoryManager();
   ~MemoryManager();
@@ -56,7 +79,8 @@ public:
   void deallocate(const MemoryObject *mo);
   void markFreed(MemoryObject *mo);
   /*
-   * Returns the size used by deterministic allocation in bytes
+   * Returns the size of the deterministic slots that are in use or in
+   * quarantine in bytes
    */
   size_t getUsedDeterministicSize();
 };
@@ -15,7 +15,6 @@
 #include "klee/Expr/ExprPPrinter.h"
 #include "klee/Support/OptionCategories.h"
 
-#include <bitset>
 #include <vector>
 
 using namespace klee;
@@ -39,7 +38,7 @@ void PForest::remove(PTreeNode *node) {
 
 void PForest::dump(llvm::raw_ostream &os) {
   for (auto &ntree : trees)
-    ntree.second->dump(os);
+    ntree.second->dump(os, registeredIds);
 }
 
 PForest::~PForest() {
@@ -22,7 +22,7 @@ class PTree;
 
 class PForest {
   // Number of registered ID
-  int registeredIds = 0;
+  unsigned registeredIds = 0;
   std::map<uint32_t, PTree *> trees;
   // The global tree counter
   std::uint32_t nextID = 1;
@@ -36,14 +36,7 @@ public:
   void remove(PTreeNode *node);
   const std::map<uint32_t, PTree *> &getPTrees() { return trees; }
   void dump(llvm::raw_ostream &os);
-  std::uint8_t getNextId() {
-    std::uint8_t id = 1 << registeredIds++;
-    if (registeredIds > PtrBitCount) {
-      klee_error("PForest cannot support more than %d RandomPathSearchers",
-                 PtrBitCount);
-    }
-    return id;
-  }
+  unsigned getNextId() { return registeredIds++; }
 };
 } // namespace klee
 
@@ -15,7 +15,6 @@
 #include "klee/Expr/ExprPPrinter.h"
 #include "klee/Support/OptionCategories.h"
 
-#include <bitset>
 #include <vector>
 
 using namespace klee;
@@ -29,6 +28,12 @@ cl::opt<bool>
                                  "tree whenever possible (default=false)"),
                         cl::init(false), cl::cat(MiscCat));
 
+void dumpTags(llvm::raw_ostream &os, const PTreeNodePtr &ptr,
+              unsigned tagCount) {
+  for (unsigned id = tagCount; id > 0; --id)
+    os << (ptr.hasTag(id - 1) ? '1' : '0');
+}
+
 } // namespace
 
 PTree::PTree(ExecutionState *initialState, uint32_t treeID) {
@@ -44,14 +49,15 @@ void PTree::attach(PTreeNode *node, ExecutionState *leftState,
          "Attach assumes the right state is the current state");
   node->state = nullptr;
   node->left = PTreeNodePtr(new PTreeNode(node, leftState, id));
-  // The current node inherits the tag
-  uint8_t currentNodeTag = root.getInt();
+  // The current node inherits the tag (and the state counts, which are those
+  // of its single state)
+  const PTreeNodePtr *currentNodePtr = &root;
   if (node->parent)
-    currentNodeTag = node->parent->left.getPointer() == node
-                         ? node->parent->left.getInt()
-                         : node->parent->right.getInt();
+    currentNodePtr = node->parent->left.getPointer() == node
+                         ? &node->parent->left
+                         : &node->parent->right;
   node->right =
-      PTreeNodePtr(new PTreeNode(node, rightState, id), currentNodeTag);
+      PTreeNodePtr(new PTreeNode(node, rightState, id), *currentNodePtr);
 }
 
 void PTree::remove(PTreeNode *n) {
@@ -94,7 +100,7 @@ void PTree::remove(PTreeNode *n) {
   }
 }
 
-void PTree::dump(llvm::raw_ostream &os) {
+void PTree::dump(llvm::raw_ostream &os, unsigned tagCount) {
   ExprPPrinter *pp = ExprPPrinter::create(os);
   pp->setNewline("\\l");
   os << "digraph G {\n";
@@ -115,14 +121,16 @@ void PTree::dump(llvm::raw_ostream &os) {
     os << "];\n";
     if (n->left.getPointer()) {
       os << "\tn" << n << " -> n" << n->left.getPointer();
-      os << " [label=0b"
-         << std::bitset<PtrBitCount>(n->left.getInt()).to_string() << "];\n";
+      os << " [label=0b";
+      dumpTags(os, n->left, tagCount);
+      os << "];\n";
       stack.push_back(n->left.getPointer());
     }
     if (n->right.getPointer()) {
       os << "\tn" << n << " -> n" << n->right.getPointer();
-      os << " [label=0b"
-         << std::bitset<PtrBitCount>(n->right.getInt()).to_string() << "];\n";
+      os << " [label=0b";
+      dumpTags(os, n->right, tagCount);
+      os << "];\n";
       stack.push_back(n->right.getPointer());
     }
   }
@@ -17,7 +17,8 @@
 #include "klee/Support/CompilerWarning.h"
 DISABLE_WARNING_PUSH
 DISABLE_WARNING_DEPRECATED_DECLARATIONS
-#include "llvm/ADT/PointerIntPair.h"
+#include "llvm/ADT/SmallBitVector.h"
+#include "llvm/ADT/SmallVector.h"
 DISABLE_WARNING_POP
 
 namespace klee {
@@ -26,10 +27,54 @@ class PTreeNode;
 /* PTreeNodePtr is used by the Random Path Searcher object to efficiently
 record which PTreeNode belongs to it. PTree is a global structure that
 captures all  states, whereas a Random Path Searcher might only care about
-a subset. The integer part of PTreeNodePtr is a bitmask (a "tag") of which
-Random Path Searchers PTreeNode belongs to. */
-constexpr int PtrBitCount = 3;
-using PTreeNodePtr = llvm::PointerIntPair<PTreeNode *, PtrBitCount, uint8_t>;
+a subset. Alongside the pointer, PTreeNodePtr keeps a bitset (a "tag") of
+which Random Path Searchers PTreeNode belongs to. The bitset is stored inline
+for the first few dozen searchers and grows on demand afterwards, so the
+number of searchers is not limited. Searchers that weight subtrees by size
+additionally keep a per-tag count of their states below the pointer. */
+class PTreeNodePtr {
+  PTreeNode *pointer = nullptr;
+  llvm::SmallBitVector tags;
+  llvm::SmallVector<std::uint32_t, 0> counts;
+
+public:
+  PTreeNodePtr() = default;
+  explicit PTreeNodePtr(PTreeNode *pointer) : pointer(pointer) {}
+  /// Points to \p pointer with the tags and counts of \p owners
+  PTreeNodePtr(PTreeNode *pointer, const PTreeNodePtr &owners)
+      : pointer(pointer), tags(owners.tags), counts(owners.counts) {}
+
+  PTreeNode *getPointer() const { return pointer; }
+  const llvm::SmallBitVector &getTags() const { return tags; }
+
+  bool hasTag(unsigned id) const { return id < tags.size() && tags.test(id); }
+  void setTag(unsigned id) {
+    if (id >= tags.size())
+      tags.resize(id + 1);
+    tags.set(id);
+  }
+  void resetTag(unsigned id) {
+    if (id < tags.size())
+      tags.reset(id);
+  }
+
+  /// Number of states of searcher \p id below this pointer. Only maintained
+  /// through addState/removeState; plain tags leave it at zero.
+  std::uint32_t getCount(unsigned id) const {
+    return id < counts.size() ? counts[id] : 0;
+  }
+  void addState(unsigned id) {
+    if (id >= counts.size())
+      counts.resize(id + 1);
+    ++counts[id];
+    setTag(id);
+  }
+  void removeState(unsigned id) {
+    assert(getCount(id) > 0 && "no state of this searcher below pointer");
+    if (--counts[id] == 0)
+      resetTag(id);
+  }
+};
 
 class PTreeNode {
 public:
@@ -62,7 +107,7 @@ public:
   void attach(PTreeNode *node, ExecutionState *leftState,
               ExecutionState *rightState, BranchType reason);
   void remove(PTreeNode *node);
-  void dump(llvm::raw_ostream &os);
+  void dump(llvm::raw_ostream &os, unsigned tagCount);
   std::uint32_t getID() const { return id; };
 };
 } // namespace klee
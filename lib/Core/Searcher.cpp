@@ -38,7 +38,9 @@ DISABLE_WARNING_POP
 
 #include <cassert>
 #include <cmath>
+#include <fstream>
 #include <set>
+#include <sstream>
 
 using namespace klee;
 using namespace llvm;
@@ -477,13 +479,188 @@ void WeightedRandomSearcher::printName(llvm::raw_ostream &os) {
 
 ///
 
+const char *LearnedSearcher::getFeatureName(Feature feature) {
+  switch (feature) {
+  case Bias:
+    return "bias";
+  case Forks:
+    return "forks";
+  case Instructions:
+    return "instructions";
+  case QueryCost:
+    return "query-cost";
+  case MinDistToUncovered:
+    return "md2u";
+  case StackDepth:
+    return "stack-depth";
+  case InstsSinceCovNew:
+    return "insts-since-cov-new";
+  default:
+    assert(0 && "invalid feature");
+    return "<unknown>";
+  }
+}
+
+LearnedSearcher::LearnedSearcher(RNG &rng, double learningRate,
+                                 std::unique_ptr<llvm::raw_ostream> featuresOS)
+    : states(std::make_unique<
+             DiscretePDF<ExecutionState *, ExecutionStateIDCompare>>()),
+      theRNG{rng}, learningRate{learningRate},
+      featuresOS{std::move(featuresOS)} {
+  // Until something is learned, behave like nurs:covnew
+  weights.fill(0.);
+  weights[MinDistToUncovered] = -1.;
+  weights[InstsSinceCovNew] = -1.;
+
+  if (this->featuresOS) {
+    *this->featuresOS << "state";
+    for (unsigned f = 0; f < FeatureCount; ++f)
+      *this->featuresOS << ',' << getFeatureName(static_cast<Feature>(f));
+    *this->featuresOS << ",reward\n";
+  }
+}
+
+LearnedSearcher::~LearnedSearcher() = default;
+
+bool LearnedSearcher::loadModel(const std::string &path, std::string &error) {
+  std::ifstream in(path);
+  if (!in) {
+    error = "cannot open " + path;
+    return false;
+  }
+
+  std::string line;
+  for (unsigned lineNo = 1; std::getline(in, line); ++lineNo) {
+    std::istringstream fields(line.substr(0, line.find('#')));
+    std::string name;
+    double weight;
+    if (!(fields >> name))
+      continue;
+    if (!(fields >> weight)) {
+      error = path + ":" + std::to_string(lineNo) + ": expected a weight";
+      return false;
+    }
+    unsigned f = 0;
+    while (f < FeatureCount && name != getFeatureName(static_cast<Feature>(f)))
+      ++f;
+    if (f == FeatureCount) {
+      error = path + ":" + std::to_string(lineNo) + ": unknown feature '" +
+              name + "'";
+      return false;
+    }
+    weights[f] = weight;
+  }
+  return true;
+}
+
+LearnedSearcher::FeatureVector
+LearnedSearcher::getFeatures(const ExecutionState &es) {
+  FeatureVector features;
+  features.fill(0.);
+  features[Bias] = 1.;
+  features[Forks] = std::log1p(es.depth);
+  features[Instructions] = std::log1p(es.steppedInstructions);
+  features[QueryCost] = std::log1p(es.queryMetaData.queryCost.toSeconds());
+  if (es.pc && !es.stack.empty()) {
+    uint64_t md2u = computeMinDistToUncovered(
+        es.pc, es.stack.infoStack().back().minDistToUncoveredOnReturn);
+    features[MinDistToUncovered] = std::log1p(md2u ? md2u : 10000);
+  }
+  features[StackDepth] = std::log1p(es.stack.size());
+  features[InstsSinceCovNew] = std::log1p(es.instsSinceCovNew);
+  return features;
+}
+
+double LearnedSearcher::getScore(const FeatureVector &features) const {
+  double score = 0.;
+  for (unsigned f = 0; f < FeatureCount; ++f)
+    score += weights[f] * features[f];
+  return score;
+}
+
+double LearnedSearcher::getWeight(ExecutionState *es) const {
+  // keep exp() finite and non-zero whatever the model says
+  double score = getScore(getFeatures(*es));
+  return std::exp(std::max(-50., std::min(50., score)));
+}
+
+void LearnedSearcher::learn(std::uint64_t reward) {
+  if (featuresOS) {
+    *featuresOS << pendingID;
+    for (auto feature : pendingFeatures)
+      *featuresOS << ',' << feature;
+    *featuresOS << ',' << reward << '\n';
+  }
+
+  if (learningRate == 0.)
+    return;
+
+  // One step of normalized least mean squares towards log(1 + reward).
+  // Plain SGD diverges once |x|^2 exceeds 2 / learningRate, which the log
+  // features of long-running states easily reach; dividing the step by
+  // 1 + |x|^2 keeps it stable for any learningRate below 2.
+  double error = std::log1p(reward) - getScore(pendingFeatures);
+  double norm = 1.;
+  for (auto feature : pendingFeatures)
+    norm += feature * feature;
+  double step = learningRate * error / norm;
+  for (unsigned f = 0; f < FeatureCount; ++f) {
+    double weight = weights[f] + step * pendingFeatures[f];
+    weights[f] = std::max(-MaxWeight, std::min(MaxWeight, weight));
+  }
+}
+
+ExecutionState &LearnedSearcher::selectState() {
+  ExecutionState *es = states->choose(theRNG.getDoubleL());
+  hasPendingSample = true;
+  pendingID = es->getID();
+  pendingFeatures = getFeatures(*es);
+  pendingCovered = stats::coveredInstructions;
+  return *es;
+}
+
+void LearnedSearcher::update(
+    ExecutionState *current, const std::vector<ExecutionState *> &addedStates,
+    const std::vector<ExecutionState *> &removedStates) {
+  if (hasPendingSample) {
+    learn(stats::coveredInstructions - pendingCovered);
+    hasPendingSample = false;
+  }
+
+  // update current
+  if (current && std::find(removedStates.begin(), removedStates.end(),
+                           current) == removedStates.end())
+    states->update(current, getWeight(current));
+
+  // insert states
+  for (const auto state : addedStates)
+    states->insert(state, getWeight(state));
+
+  // remove states
+  for (const auto state : removedStates)
+    states->remove(state);
+}
+
+bool LearnedSearcher::empty() { return states->empty(); }
+
+void LearnedSearcher::printName(llvm::raw_ostream &os) {
+  os << "LearnedSearcher (";
+  for (unsigned f = 0; f < FeatureCount; ++f) {
+    if (f)
+      os << ", ";
+    os << getFeatureName(static_cast<Feature>(f)) << '=' << weights[f];
+  }
+  os << ")\n";
+}
+
 // Check if n is a valid pointer and a node belonging to us
 #define IS_OUR_NODE_VALID(n)                                                   \
-  (((n).getPointer() != nullptr) && (((n).getInt() & idBitMask) != 0))
+  (((n).getPointer() != nullptr) && (n).hasTag(idBit))
 
-RandomPathSearcher::RandomPathSearcher(PForest &processForest, RNG &rng)
-    : processForest{processForest}, theRNG{rng},
-      idBitMask{processForest.getNextId()} {};
+RandomPathSearcher::RandomPathSearcher(PForest &processForest, RNG &rng,
+                                       Descent descent)
+    : processForest{processForest}, theRNG{rng}, descent{descent},
+      idBit{processForest.getNextId()} {};
 
 ExecutionState &RandomPathSearcher::selectState() {
   unsigned flips = 0, bits = 0, range = 0;
@@ -492,7 +669,7 @@ ExecutionState &RandomPathSearcher::selectState() {
     root = &processForest.getPTrees()
                 .at(range++ % processForest.getPTrees().size() + 1)
                 ->root;
-  assert(root->getInt() & idBitMask && "Root should belong to the searcher");
+  assert(root->hasTag(idBit) && "Root should belong to the searcher");
   PTreeNode *n = root->getPointer();
   while (!n->state) {
     if (!IS_OUR_NODE_VALID(n->left)) {
@@ -504,6 +681,11 @@ ExecutionState &RandomPathSearcher::selectState() {
       assert(IS_OUR_NODE_VALID(n->left) && "Both right and left nodes invalid");
       assert(n != n->left.getPointer());
       n = n->left.getPointer();
+    } else if (descent == SubtreeSize) {
+      std::uint32_t leftStates = n->left.getCount(idBit);
+      std::uint32_t total = leftStates + n->right.getCount(idBit);
+      n = (theRNG.getInt32() % total < leftStates ? n->left : n->right)
+              .getPointer();
     } else {
       if (bits == 0) {
         flips = theRNG.getInt32();
@@ -520,6 +702,11 @@ ExecutionState &RandomPathSearcher::selectState() {
 void RandomPathSearcher::update(
     ExecutionState *current, const std::vector<ExecutionState *> &addedStates,
     const std::vector<ExecutionState *> &removedStates) {
+  if (descent == SubtreeSize) {
+    updateStateCounts(addedStates, removedStates);
+    return;
+  }
+
   // insert states
   for (auto &es : addedStates) {
     PTreeNode *pnode = es->ptreeNode, *parent = pnode->parent;
@@ -530,7 +717,7 @@ void RandomPathSearcher::update(
                                                               : &parent->right)
                       : &root;
     while (pnode && !IS_OUR_NODE_VALID(*childPtr)) {
-      childPtr->setInt(childPtr->getInt() | idBitMask);
+      childPtr->setTag(idBit);
       pnode = parent;
       if (pnode)
         parent = pnode->parent;
@@ -554,7 +741,7 @@ void RandomPathSearcher::update(
                                                          : &parent->right)
                  : &root;
       assert(IS_OUR_NODE_VALID(*childPtr) && "Removing pTree child not ours");
-      childPtr->setInt(childPtr->getInt() & ~idBitMask);
+      childPtr->resetTag(idBit);
       pnode = parent;
       if (pnode)
         parent = pnode->parent;
@@ -562,6 +749,38 @@ void RandomPathSearcher::update(
   }
 }
 
+void RandomPathSearcher::updateStateCounts(
+    const std::vector<ExecutionState *> &addedStates,
+    const std::vector<ExecutionState *> &removedStates) {
+  // Every pointer on the path to the root counts the states of this searcher
+  // below it, so unlike the plain tags the walk cannot stop early.
+  auto pathToRoot = [this](ExecutionState *es) {
+    std::vector<PTreeNodePtr *> path;
+    PTreeNode *pnode = es->ptreeNode;
+    for (PTreeNode *parent = pnode->parent; parent;
+         pnode = parent, parent = parent->parent)
+      path.push_back(parent->left.getPointer() == pnode ? &parent->left
+                                                        : &parent->right);
+    path.push_back(&processForest.getPTrees().at(pnode->getTreeID())->root);
+    return path;
+  };
+
+  for (auto es : addedStates) {
+    auto path = pathToRoot(es);
+    if (IS_OUR_NODE_VALID(*path.front()))
+      continue;
+    for (auto ptr : path)
+      ptr->addState(idBit);
+  }
+
+  for (auto es : removedStates) {
+    auto path = pathToRoot(es);
+    assert(IS_OUR_NODE_VALID(*path.front()) && "Removing pTree child not ours");
+    for (auto ptr : path)
+      ptr->removeState(idBit);
+  }
+}
+
 bool RandomPathSearcher::empty() {
   bool res = true;
   for (const auto &ntree : processForest.getPTrees())
@@ -570,7 +789,10 @@ bool RandomPathSearcher::empty() {
 }
 
 void RandomPathSearcher::printName(llvm::raw_ostream &os) {
-  os << "RandomPathSearcher\n";
+  os << "RandomPathSearcher";
+  if (descent == SubtreeSize)
+    os << " (subtree size)";
+  os << "\n";
 }
 
 ///
@@ -643,6 +865,66 @@ void BatchingSearcher::printName(llvm::raw_ostream &os) {
 
 ///
 
+BatchSteppingSearcher::BatchSteppingSearcher(Searcher *baseSearcher,
+                                             unsigned batchSize,
+                                             unsigned instructionBudget)
+    : baseSearcher{baseSearcher}, batchSize{std::max(1U, batchSize)},
+      instructionBudget{instructionBudget} {}
+
+bool BatchSteppingSearcher::sliceEnded() const {
+  return runningForked ||
+         (instructionBudget &&
+          stats::instructions - sliceStartInstructions >= instructionBudget) ||
+         stats::externalCalls != sliceStartExternalCalls;
+}
+
+ExecutionState &BatchSteppingSearcher::selectState() {
+  if (running && !sliceEnded())
+    return *running;
+
+  // Members of a batch are drawn one at a time, right before their slice
+  // starts, so every selection of the underlying searcher is followed by the
+  // updates of the slice it started. Searchers that remember their last
+  // selection (e.g. LearnedSearcher) rely on this. The batch ends when it is
+  // full or when the underlying searcher selects one of its states again.
+  running = &baseSearcher->selectState();
+  if (batch.size() == batchSize ||
+      std::find(batch.begin(), batch.end(), running) != batch.end())
+    batch.clear();
+  batch.push_back(running);
+
+  runningForked = false;
+  sliceStartInstructions = stats::instructions;
+  sliceStartExternalCalls = stats::externalCalls;
+  return *running;
+}
+
+void BatchSteppingSearcher::update(
+    ExecutionState *current, const std::vector<ExecutionState *> &addedStates,
+    const std::vector<ExecutionState *> &removedStates) {
+  if (running && current == running && !addedStates.empty())
+    runningForked = true;
+
+  for (const auto state : removedStates) {
+    if (state == running)
+      running = nullptr;
+    auto it = std::find(batch.begin(), batch.end(), state);
+    if (it != batch.end())
+      batch.erase(it);
+  }
+
+  baseSearcher->update(current, addedStates, removedStates);
+}
+
+bool BatchSteppingSearcher::empty() { return baseSearcher->empty(); }
+
+void BatchSteppingSearcher::printName(llvm::raw_ostream &os) {
+  os << "<BatchSteppingSearcher> batchSize: " << batchSize
+     << ", instructionBudget: " << instructionBudget << ", baseSearcher:\n";
+  baseSearcher->printName(os);
+  os << "</BatchSteppingSearcher>\n";
+}
+
 class TimeMetric final : public IterativeDeepeningSearcher::Metric {
   time::Point startTime;
   time::Span time{time::seconds(1)};
@@ -752,6 +1034,87 @@ void IterativeDeepeningSearcher::printName(llvm::raw_ostream &os) {
 
 ///
 
+MergingSearcher::MergingSearcher(Searcher *baseSearcher,
+                                 std::uint64_t maxPauseInstructions)
+    : baseSearcher{baseSearcher}, maxPauseInstructions{maxPauseInstructions} {}
+
+void MergingSearcher::pauseState(ExecutionState &state) {
+  statesToPause.push_back(&state);
+}
+
+void MergingSearcher::continueState(ExecutionState &state) {
+  statesToContinue.push_back(&state);
+}
+
+ExecutionState &MergingSearcher::selectState() {
+  return baseSearcher->selectState();
+}
+
+void MergingSearcher::update(ExecutionState *current,
+                             const StatesVector &addedStates,
+                             const StatesVector &removedStates) {
+  // update underlying searcher (filter paused states unknown to underlying
+  // searcher)
+  activeRemovedStates.clear();
+  for (auto state : removedStates) {
+    if (!pausedStates.erase(state))
+      activeRemovedStates.push_back(state);
+  }
+  baseSearcher->update(current, addedStates, activeRemovedStates);
+
+  // revive merged states and states that waited for too long
+  StatesVector revived;
+  for (auto state : statesToContinue) {
+    if (pausedStates.erase(state))
+      revived.push_back(state);
+  }
+  statesToContinue.clear();
+  if (maxPauseInstructions) {
+    for (auto it = pausedStates.begin(); it != pausedStates.end();) {
+      if (stats::instructions - it->second > maxPauseInstructions) {
+        revived.push_back(it->first);
+        it = pausedStates.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  // pause states that reached a join point
+  StatesVector paused;
+  for (auto state : statesToPause) {
+    if (std::find(removedStates.begin(), removedStates.end(), state) ==
+        removedStates.end()) {
+      pausedStates.emplace(state, stats::instructions);
+      paused.push_back(state);
+    }
+  }
+  statesToPause.clear();
+  if (!revived.empty() || !paused.empty())
+    baseSearcher->update(nullptr, revived, paused);
+
+  // no states left in underlying searcher: nobody can join the paused ones
+  if (baseSearcher->empty() && !pausedStates.empty()) {
+    StatesVector ps;
+    for (auto &pausedState : pausedStates)
+      ps.push_back(pausedState.first);
+    baseSearcher->update(nullptr, ps, {});
+    pausedStates.clear();
+  }
+}
+
+bool MergingSearcher::empty() {
+  return baseSearcher->empty() && pausedStates.empty();
+}
+
+void MergingSearcher::printName(llvm::raw_ostream &os) {
+  os << "<MergingSearcher> containing:\n";
+  baseSearcher->printName(os);
+  os << "</MergingSearcher>\n";
+}
+
+///
+
 InterleavedSearcher::InterleavedSearcher(
     const std::vector<Searcher *> &_searchers) {
   searchers.reserve(_searchers.size());
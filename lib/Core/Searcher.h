@@ -27,7 +27,9 @@ DISABLE_WARNING_DEPRECATED_DECLARATIONS
 #include "llvm/Support/raw_ostream.h"
 DISABLE_WARNING_POP
 
+#include <array>
 #include <map>
+#include <memory>
 #include <queue>
 #include <set>
 #include <unordered_map>
@@ -79,13 +81,15 @@ public:
     BFS,
     RandomState,
     RandomPath,
+    RandomPathStates,
     NURS_CovNew,
     NURS_MD2U,
     NURS_Depth,
     NURS_RP,
     NURS_ICnt,
     NURS_CPICnt,
-    NURS_QC
+    NURS_QC,
+    Learned
   };
 };
 
@@ -248,33 +252,112 @@ public:
   void printName(llvm::raw_ostream &os) override;
 };
 
+/// LearnedSearcher scores every state with a linear model over a small
+/// feature vector (see Feature) and selects states randomly with weight
+/// exp(score). The features of each selected state are paired with the
+/// number of instructions newly covered while it ran. These pairs update the
+/// model online with normalized least mean squares, and can be exported for
+/// offline training. As with WeightedRandomSearcher, only the weight of the
+/// current state is recomputed on update.
+class LearnedSearcher final : public Searcher {
+public:
+  enum Feature : std::uint8_t {
+    Bias,
+    Forks,
+    Instructions,
+    QueryCost,
+    MinDistToUncovered,
+    StackDepth,
+    InstsSinceCovNew,
+    FeatureCount
+  };
+  using FeatureVector = std::array<double, FeatureCount>;
+
+  static const char *getFeatureName(Feature feature);
+
+  /// Learned weights are clipped to [-MaxWeight, MaxWeight]
+  static constexpr double MaxWeight = 100.;
+
+private:
+  std::unique_ptr<DiscretePDF<ExecutionState *, ExecutionStateIDCompare>>
+      states;
+  RNG &theRNG;
+  FeatureVector weights;
+  double learningRate;
+  std::unique_ptr<llvm::raw_ostream> featuresOS;
+
+  /// Features of the last selected state, awaiting their reward
+  bool hasPendingSample = false;
+  std::uint32_t pendingID = 0;
+  FeatureVector pendingFeatures;
+  std::uint64_t pendingCovered = 0;
+
+  double getScore(const FeatureVector &features) const;
+  double getWeight(ExecutionState *es) const;
+  void learn(std::uint64_t reward);
+
+public:
+  /// \param rng A random number generator.
+  /// \param learningRate Step size of online updates (0 disables learning).
+  /// \param featuresOS If non-null, every (features, reward) sample is
+  /// written to it as a CSV row.
+  LearnedSearcher(RNG &rng, double learningRate,
+                  std::unique_ptr<llvm::raw_ostream> featuresOS = nullptr);
+  ~LearnedSearcher() override;
+
+  /// Reads `<feature name> <weight>` lines from \p path; '#' starts a
+  /// comment. Features not mentioned keep their current weight.
+  /// \return false and sets \p error if the file cannot be parsed.
+  bool loadModel(const std::string &path, std::string &error);
+  const FeatureVector &getModel() const { return weights; }
+  static FeatureVector getFeatures(const ExecutionState &es);
+
+  ExecutionState &selectState() override;
+  void update(ExecutionState *current,
+              const std::vector<ExecutionState *> &addedStates,
+              const std::vector<ExecutionState *> &removedStates) override;
+  bool empty() override;
+  void printName(llvm::raw_ostream &os) override;
+};
+
 /// RandomPathSearcher performs a random walk of the PTree to select a state.
 /// PTree is a global data structure, however, a searcher can sometimes only
 /// select from a subset of all states (depending on the update calls).
 ///
 /// To support this, RandomPathSearcher has a subgraph view of PTree, in that it
-/// only walks the PTreeNodes that it "owns". Ownership is stored in the
-/// getInt method of the PTreeNodePtr class (which hides it in the pointer
-/// itself).
-///
-/// The current implementation of PTreeNodePtr supports only 3 instances of the
-/// RandomPathSearcher. This is because the current PTreeNodePtr implementation
-/// conforms to C++ and only steals the last 3 alignment bits. This restriction
-/// could be relaxed slightly by an architecture-specific implementation of
-/// PTreeNodePtr that also steals the top bits of the pointer.
+/// only walks the PTreeNodes that it "owns". Ownership is stored as one bit
+/// of the tag bitset kept next to the pointer in PTreeNodePtr. Every searcher
+/// gets its own bit from PForest, so any number of RandomPathSearchers can
+/// share one PForest.
 ///
 /// The ownership bits are maintained in the update method.
+///
+/// By default every branch is taken with a fair coin, which favours shallow
+/// subtrees. With SubtreeSize descent, a branch is taken with probability
+/// proportional to the number of this searcher's states below it, which still
+/// costs O(depth) per selection. These counts are kept per tag in PTreeNodePtr
+/// and cost an O(depth) walk on every update.
 class RandomPathSearcher final : public Searcher {
+public:
+  enum Descent { Coin, SubtreeSize };
+
+private:
   PForest &processForest;
   RNG &theRNG;
+  Descent descent;
+
+  // Unique tag bit of this searcher
+  const unsigned idBit;
 
-  // Unique bitmask of this searcher
-  const uint8_t idBitMask;
+  void updateStateCounts(const std::vector<ExecutionState *> &addedStates,
+                         const std::vector<ExecutionState *> &removedStates);
 
 public:
   /// \param processTree The process tree.
   /// \param RNG A random number generator.
-  RandomPathSearcher(PForest &processForest, RNG &rng);
+  /// \param descent How to choose between two owned children.
+  RandomPathSearcher(PForest &processForest, RNG &rng,
+                     Descent descent = Coin);
   ~RandomPathSearcher() override = default;
 
   ExecutionState &selectState() override;
@@ -319,6 +402,45 @@ public:
   void printName(llvm::raw_ostream &os) override;
 };
 
+/// BatchSteppingSearcher groups up to `batchSize` distinct states selected by
+/// the underlying searcher into a batch and steps them one after another on
+/// the interpreter thread. Each state runs for a slice that ends when it
+/// forks, performs an external call or exhausts its instruction budget. The
+/// slices of a batch only share state through the executor, so they are the
+/// unit of work a parallel executor would step concurrently; stepping them on
+/// several threads is not implemented.
+class BatchSteppingSearcher final : public Searcher {
+  std::unique_ptr<Searcher> baseSearcher;
+  const unsigned batchSize;
+  const unsigned instructionBudget;
+
+  /// States whose slices ran in the current batch
+  std::vector<ExecutionState *> batch;
+
+  ExecutionState *running = nullptr;
+  bool runningForked = false;
+  std::uint64_t sliceStartInstructions = 0;
+  std::uint64_t sliceStartExternalCalls = 0;
+
+  bool sliceEnded() const;
+
+public:
+  /// \param baseSearcher The underlying searcher (takes ownership).
+  /// \param batchSize Maximal number of states in a batch.
+  /// \param instructionBudget Number of instructions after which the slice
+  /// of a state ends (0 = unlimited).
+  BatchSteppingSearcher(Searcher *baseSearcher, unsigned batchSize,
+                        unsigned instructionBudget);
+  ~BatchSteppingSearcher() override = default;
+
+  ExecutionState &selectState() override;
+  void update(ExecutionState *current,
+              const std::vector<ExecutionState *> &addedStates,
+              const std::vector<ExecutionState *> &removedStates) override;
+  bool empty() override;
+  void printName(llvm::raw_ostream &os) override;
+};
+
 /// IterativeDeepeningSearcher implements a metric-based deepening. States
 /// are selected from an underlying searcher. When a state exceeds its metric
 /// limit, it is paused (removed from underlying searcher). When the underlying
@@ -355,6 +477,46 @@ public:
   void printName(llvm::raw_ostream &os) override;
 };
 
+/// MergingSearcher lets the executor park states at join points so that
+/// they can be merged with sibling states arriving at the same point (see
+/// --use-state-merging). Paused states are removed from the underlying
+/// searcher. They are revived once they are merged with another state, when
+/// they have waited for more than a given number of instructions, or when
+/// the underlying searcher runs out of states.
+class MergingSearcher final : public Searcher {
+  std::unique_ptr<Searcher> baseSearcher;
+  /// Paused states and the instruction count at which they were paused
+  std::map<ExecutionState *, std::uint64_t, ExecutionStateIDCompare>
+      pausedStates;
+  StatesVector statesToPause;
+  StatesVector statesToContinue;
+  StatesVector activeRemovedStates;
+  const std::uint64_t maxPauseInstructions;
+
+public:
+  /// \param baseSearcher The underlying searcher (takes ownership).
+  /// \param maxPauseInstructions Number of executed instructions after which
+  /// a paused state is revived even if no merge partner arrived (0 = never).
+  MergingSearcher(Searcher *baseSearcher, std::uint64_t maxPauseInstructions);
+  ~MergingSearcher() override = default;
+
+  /// Pauses \p state at the next update.
+  void pauseState(ExecutionState &state);
+  /// Revives the paused \p state at the next update.
+  void continueState(ExecutionState &state);
+  const std::map<ExecutionState *, std::uint64_t, ExecutionStateIDCompare> &
+  getPausedStates() const {
+    return pausedStates;
+  }
+
+  ExecutionState &selectState() override;
+  void update(ExecutionState *current,
+              const std::vector<ExecutionState *> &addedStates,
+              const std::vector<ExecutionState *> &removedStates) override;
+  bool empty() override;
+  void printName(llvm::raw_ostream &os) override;
+};
+
 /// InterleavedSearcher selects states from a set of searchers in round-robin
 /// manner. It is used for KLEE's default strategy where it switches between
 /// RandomPathSearcher and WeightedRandomSearcher with CoveringNew metric.
@@ -256,39 +256,38 @@ void SpecialFunctionHandler::prepare(
 
 void SpecialFunctionHandler::bind() {
   unsigned N = size();
+  handlers.assign(executor.kmodule->functions.size(), {nullptr, false});
 
   for (unsigned i = 0; i < N; ++i) {
     HandlerInfo &hi = handlerInfo[i];
     Function *f = executor.kmodule->module->getFunction(hi.name);
 
     if (f && (!hi.doNotOverride || f->isDeclaration())) {
-      handlers[f] = std::make_pair(hi.handler, hi.hasReturnValue);
-
-      if (executor.kmodule->functionMap.count(f)) {
-        executor.kmodule->functionMap.at(f)->kleeHandled = true;
-      }
+      auto kf = executor.kmodule->functionMap.find(f);
+      if (kf == executor.kmodule->functionMap.end())
+        continue;
+      handlers[kf->second->id] = std::make_pair(hi.handler, hi.hasReturnValue);
+      kf->second->kleeHandled = true;
     }
   }
 }
 
-bool SpecialFunctionHandler::handle(ExecutionState &state, Function *f,
+bool SpecialFunctionHandler::handle(ExecutionState &state, const KFunction *kf,
                                     KInstruction *target,
                                     std::vector<ref<Expr>> &arguments) {
-  handlers_ty::iterator it = handlers.find(f);
-  if (it != handlers.end()) {
-    Handler h = it->second.first;
-    bool hasReturnValue = it->second.second;
-    // FIXME: Check this... add test?
-    if (!hasReturnValue && !target->inst()->use_empty()) {
-      executor.terminateStateOnExecError(
-          state, "expected return value from void special function");
-    } else {
-      (this->*h)(state, target, arguments);
-    }
-    return true;
-  } else {
+  if (!kf->kleeHandled)
     return false;
+
+  Handler h = handlers[kf->id].first;
+  bool hasReturnValue = handlers[kf->id].second;
+  // FIXME: Check this... add test?
+  if (!hasReturnValue && !target->inst()->use_empty()) {
+    executor.terminateStateOnExecError(
+        state, "expected return value from void special function");
+  } else {
+    (this->*h)(state, target, arguments);
   }
+  return true;
 }
 
 /****/
@@ -1060,7 +1059,7 @@ void SpecialFunctionHandler::handleMakeMock(ExecutionState &state,
       case MockStrategyKind::Deterministic:
         std::vector<ref<Expr>> args(kf->getNumArgs());
         for (size_t i = 0; i < kf->getNumArgs(); i++) {
-          args[i] = executor.getArgumentCell(state, kf, i).value;
+          args[i] = executor.getArgumentCell(state, kf, i).value();
         }
         source = SourceBuilder::mockDeterministic(executor.kmodule.get(),
                                                   *kf->function(), args);
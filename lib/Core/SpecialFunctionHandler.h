@@ -26,6 +26,7 @@ class Executor;
 class Expr;
 class PointerExpr;
 class ExecutionState;
+struct KFunction;
 struct KInstruction;
 template <typename T> class ref;
 
@@ -34,8 +35,9 @@ public:
   typedef void (SpecialFunctionHandler::*Handler)(
       ExecutionState &state, KInstruction *target,
       std::vector<ref<Expr>> &arguments);
-  typedef std::map<const llvm::Function *, std::pair<Handler, bool>>
-      handlers_ty;
+  /// Handler and whether it has a return value, indexed by KFunction id.
+  /// Functions without a special handler have a null entry.
+  typedef std::vector<std::pair<Handler, bool>> handlers_ty;
 
   handlers_ty handlers;
   class Executor &executor;
@@ -94,7 +96,7 @@ public:
   /// prepared for execution.
   void bind();
 
-  bool handle(ExecutionState &state, llvm::Function *f, KInstruction *target,
+  bool handle(ExecutionState &state, const KFunction *kf, KInstruction *target,
               std::vector<ref<Expr>> &arguments);
 
   /* Convenience routines */
@@ -13,6 +13,7 @@
 
 #include "klee/Config/Version.h"
 #include "klee/Core/TerminationTypes.h"
+#include "klee/Expr/Expr.h"
 #include "klee/Module/KInstruction.h"
 #include "klee/Module/KModule.h"
 #include "klee/Module/LocationInfo.h"
@@ -36,6 +37,7 @@ DISABLE_WARNING_DEPRECATED_DECLARATIONS
 #include "llvm/IR/CFG.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/InlineAsm.h"
+#include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/Module.h"
@@ -232,26 +234,34 @@ StatsTracker::StatsTracker(Executor &_executor, std::string _objectFilename,
     }
   }
 
-  if (useStatistics() || userSearcherRequiresMD2U())
+  bool useIndexedStats = useStatistics() || userSearcherRequiresMD2U();
+  if (useIndexedStats)
     theStatisticManager->useIndexedStats(km->getMaxGlobalIndex());
 
+  // Walk the LLVM instructions, so that functions need not be built
   for (auto &kfp : km->functions) {
     KFunction *kf = kfp.get();
-
-    for (unsigned i = 0; i < kf->numInstructions; ++i) {
-      KInstruction *ki = kf->instructions[i];
-
-      if (OutputIStats) {
-        unsigned id = ki->getGlobalIndex();
+    unsigned position = 0;
+    // Functions that did not change since an earlier run count as covered
+    bool unchanged = km->unchangedFunctions.count(kf);
+
+    for (auto &instr : llvm::instructions(kf->function())) {
+      unsigned id = kf->getInstructionGlobalIndex(position);
+      if (unchanged) {
+        if (useIndexedStats && instructionIsCoverable(&instr))
+          theStatisticManager->setIndexedValue(stats::coveredInstructions, id,
+                                               1);
+      } else if (OutputIStats) {
         theStatisticManager->setIndex(id);
-        if (instructionIsCoverable(ki->inst())) {
+        if (instructionIsCoverable(&instr)) {
           ++stats::uncoveredInstructions;
         }
       }
 
-      if (BranchInst *bi = dyn_cast<BranchInst>(ki->inst()))
+      if (BranchInst *bi = dyn_cast<BranchInst>(&instr))
         if (!bi->isUnconditional())
           numBranches++;
+      ++position;
     }
   }
 
@@ -530,7 +540,11 @@ void StatsTracker::writeStatsHeader() {
          << "InhibitedForks INTEGER,"
          << "ExternalCalls INTEGER,"
          << "Allocations INTEGER,"
-         << "States INTEGER," BRANCH_TYPES TERMINATION_CLASSES
+         << "States INTEGER,"
+         << "Expressions INTEGER,"
+         << "CachedConstants INTEGER,"
+         << "CopiedFrames INTEGER,"
+         << "SummarizedCalls INTEGER," BRANCH_TYPES TERMINATION_CLASSES
          << "ArrayHashTime INTEGER" << ')';
   char *zErrMsg = nullptr;
   if (sqlite3_exec(statsFile, create.str().c_str(), nullptr, nullptr,
@@ -579,7 +593,11 @@ void StatsTracker::writeStatsHeader() {
          << "InhibitedForks,"
          << "ExternalCalls,"
          << "Allocations,"
-         << "States," BRANCH_TYPES TERMINATION_CLASSES << "ArrayHashTime"
+         << "States,"
+         << "Expressions,"
+         << "CachedConstants,"
+         << "CopiedFrames,"
+         << "SummarizedCalls," BRANCH_TYPES TERMINATION_CLASSES << "ArrayHashTime"
          << ')';
 #undef BTYPE
 #define BTYPE(Name, I) << "?,"
@@ -611,6 +629,10 @@ void StatsTracker::writeStatsHeader() {
          << "?,"
          << "?,"
          << "?,"
+         << "?,"
+         << "?,"
+         << "?,"
+         << "?,"
          << "?," BRANCH_TYPES TERMINATION_CLASSES << "? " << ')';
 
   if (sqlite3_prepare_v2(statsFile, insert.str().c_str(), -1, &insertStmt,
@@ -662,6 +684,10 @@ void StatsTracker::writeStatsLine() {
   sqlite3_bind_int64(insertStmt, arg++, stats::externalCalls);
   sqlite3_bind_int64(insertStmt, arg++, stats::allocations);
   sqlite3_bind_int64(insertStmt, arg++, ExecutionState::getLastID());
+  sqlite3_bind_int64(insertStmt, arg++, Expr::count);
+  sqlite3_bind_int64(insertStmt, arg++, ConstantExpr::getNumCachedConstants());
+  sqlite3_bind_int64(insertStmt, arg++, stats::copiedFrames);
+  sqlite3_bind_int64(insertStmt, arg++, stats::summarizedCalls);
   BRANCH_TYPES
   TERMINATION_CLASSES
 #ifdef KLEE_ARRAY_DEBUG
@@ -777,20 +803,22 @@ void StatsTracker::writeIStats() {
       }
 
       of << "fn=" << fn.getName().str() << "\n";
+      KFunction *kf = executor.kmodule->functionMap.at(&fn);
+      unsigned position = 0;
       for (auto &bb : fn) {
         for (auto &instr : bb) {
           Instruction *instrPtr = &instr;
 
           auto instrLI = getLocationInfo(instrPtr);
 
-          unsigned index = executor.kmodule->getGlobalIndex(instrPtr);
+          unsigned index = kf->getInstructionGlobalIndex(position++);
           if (instrLI.file != sourceFile) {
             of << "fl=" << instrLI.file << "\n";
             sourceFile = instrLI.file;
           }
 
           {
-            auto asmLine = executor.kmodule->getAsmLine(instrPtr);
+            auto asmLine = executor.kmodule->getAsmLine(index);
             assert(asmLine.has_value());
             of << asmLine.value() << " ";
           }
@@ -823,7 +851,7 @@ void StatsTracker::writeIStats() {
                 of << fli.line << "\n";
 
                 {
-                  auto asmLine = executor.kmodule->getAsmLine(instrPtr);
+                  auto asmLine = executor.kmodule->getAsmLine(index);
                   assert(asmLine.has_value());
                   of << asmLine.value() << " ";
                 }
@@ -940,7 +968,9 @@ void StatsTracker::computeReachableUncovered() {
                            cb, /*moduleIsFullyLinked=*/true)) {
               callTargets[inst].push_back(target);
             } else {
-              for (auto kf : km->escapingFunctions) {
+              KFunctionSet targets;
+              km->getIndirectCallTargets(cb, targets);
+              for (auto kf : targets) {
                 callTargets[inst].push_back(kf->function());
               }
             }
@@ -37,6 +37,7 @@ void TargetCalculator::update(const ExecutionState &state) {
 
   if (state.prevPC == state.prevPC->parent->getLastInstruction() &&
       !fullyCoveredFunctions.count(state.pc->parent->parent)) {
+    markCoveredIfUnchanged(state.pc->parent->parent);
     auto &fBranches = getCoverageTargets(state.pc->parent->parent);
     if (!coveredFunctionsInBranches.count(state.pc->parent->parent)) {
       if (fBranches.count(state.pc->parent) != 0) {
@@ -54,6 +55,7 @@ void TargetCalculator::update(const ExecutionState &state) {
 
   if (state.prevPC == state.prevPC->parent->getLastInstruction() &&
       !fullyCoveredFunctions.count(state.prevPC->parent->parent)) {
+    markCoveredIfUnchanged(state.prevPC->parent->parent);
     auto &fBranches = getCoverageTargets(state.prevPC->parent->parent);
 
     if (!coveredFunctionsInBranches.count(state.prevPC->parent->parent)) {
@@ -96,9 +98,10 @@ void TargetCalculator::update(const ExecutionState &state) {
       while (!fns.empty() && covered) {
         KFunction *currKF = fns.front();
         fnsTaken.insert(currKF);
-        for (auto &kcallBlock : currKF->kCallBlocks) {
+        for (auto &kcallBlock : currKF->getKCallBlocks()) {
           if (kcallBlock->calledFunctions.size() == 1) {
             auto calledFunction = *kcallBlock->calledFunctions.begin();
+            markCoveredIfUnchanged(calledFunction);
             if (calledFunction->numInstructions != 0 &&
                 coveredFunctionsInBranches.count(calledFunction) == 0 &&
                 !getCoverageTargets(calledFunction).empty()) {
@@ -168,9 +171,18 @@ TargetCalculator::getCoverageTargets(KFunction *kf) {
   }
 }
 
+void TargetCalculator::markCoveredIfUnchanged(KFunction *kf) {
+  if (coveredFunctionsInBranches.count(kf) ||
+      !kf->parent->unchangedFunctions.count(kf))
+    return;
+  coveredBranches[kf] = getCoverageTargets(kf);
+  coveredFunctionsInBranches.insert(kf);
+}
+
 bool TargetCalculator::uncoveredBlockPredicate(KBlock *kblock) {
   bool result = false;
 
+  markCoveredIfUnchanged(kblock->parent);
   auto &fBranches = getCoverageTargets(kblock->parent);
 
   if (fBranches.count(kblock) != 0 || isa<KCallBlock>(kblock)) {
@@ -199,12 +211,12 @@ TargetHashSet TargetCalculator::calculate(ExecutionState &state) {
   BasicBlock *bb = state.getPCBlock();
   const KModule &module = *state.pc->parent->parent->parent;
   KFunction *kf = module.functionMap.at(bb->getParent());
-  KBlock *kb = kf->blockMap[bb];
+  KBlock *kb = kf->getBlockMap().at(bb);
   kb = !isa<KCallBlock>(kb) || (kb->getLastInstruction() != state.pc)
            ? kb
-           : kf->blockMap[state.pc->parent->basicBlock()
-                              ->getTerminator()
-                              ->getSuccessor(0)];
+           : kf->getBlockMap().at(state.pc->parent->basicBlock()
+                                      ->getTerminator()
+                                      ->getSuccessor(0));
   for (auto sfi = state.stack.callStack().rbegin(),
             sfe = state.stack.callStack().rend();
        sfi != sfe; sfi++) {
@@ -260,9 +272,9 @@ TargetHashSet TargetCalculator::calculate(ExecutionState &state) {
 
       kb = !isa<KCallBlock>(kb) || (kb->getLastInstruction() != sfi->caller)
                ? kb
-               : kf->blockMap[sfi->caller->parent->basicBlock()
-                                  ->getTerminator()
-                                  ->getSuccessor(0)];
+               : kf->getBlockMap().at(sfi->caller->parent->basicBlock()
+                                          ->getTerminator()
+                                          ->getSuccessor(0));
     }
   }
 
@@ -64,6 +64,7 @@ public:
   TargetHashSet calculate(ExecutionState &state);
 
   bool isCovered(KFunction *kf) const;
+
   bool uncoveredBlockPredicate(KBlock *kblock);
 
 private:
@@ -74,6 +75,11 @@ private:
   StatesSet localStates;
 
   const KBlockMap<std::set<unsigned>> &getCoverageTargets(KFunction *kf);
+
+  /// Treat all coverage targets of kf as covered if the function did not
+  /// change since an earlier run. Called when a function is first looked
+  /// at, so that unchanged functions are not built up front.
+  void markCoveredIfUnchanged(KFunction *kf);
 };
 } // namespace klee
 
@@ -347,7 +347,7 @@ TargetedExecutionManager::prepareAllLocations(KModule *kmodule,
       for (const auto func : relatedFunctions) {
         const auto kfunc = kmodule->functionMap[func];
 
-        for (const auto &kblock : kfunc->blocks) {
+        for (const auto &kblock : kfunc->getBlocks()) {
           auto b = kblock.get();
           if (!loc->isInside(b, origInstsInFile)) {
             continue;
@@ -42,6 +42,9 @@ cl::list<Searcher::CoreSearchType> CoreSearch(
                    "randomly select a state to explore"),
         clEnumValN(Searcher::RandomPath, "random-path",
                    "use Random Path Selection (see OSDI'08 paper)"),
+        clEnumValN(Searcher::RandomPathStates, "random-path:states",
+                   "use Random Path Selection weighted by the number of live "
+                   "states in each subtree"),
         clEnumValN(Searcher::NURS_CovNew, "nurs:covnew",
                    "use Non Uniform Random Search (NURS) with Coverage-New"),
         clEnumValN(Searcher::NURS_MD2U, "nurs:md2u",
@@ -52,9 +55,31 @@ cl::list<Searcher::CoreSearchType> CoreSearch(
                    "use NURS with Instr-Count"),
         clEnumValN(Searcher::NURS_CPICnt, "nurs:cpicnt",
                    "use NURS with CallPath-Instr-Count"),
-        clEnumValN(Searcher::NURS_QC, "nurs:qc", "use NURS with Query-Cost")),
+        clEnumValN(Searcher::NURS_QC, "nurs:qc", "use NURS with Query-Cost"),
+        clEnumValN(Searcher::Learned, "learned",
+                   "use NURS with a linear model over state features, trained "
+                   "online on coverage (see --learned-searcher-*)")),
     cl::cat(SearchCat));
 
+cl::opt<std::string> LearnedSearcherModel(
+    "learned-searcher-model",
+    cl::desc("Initial weights for --search=learned, one '<feature> <weight>' "
+             "pair per line (default=built-in weights)"),
+    cl::init(""), cl::cat(SearchCat));
+
+cl::opt<double> LearnedSearcherRate(
+    "learned-searcher-rate",
+    cl::desc("Learning rate of the online updates of --search=learned.  "
+             "Updates are normalized, so rates below 2 are stable.  Set to 0 "
+             "to keep the model fixed (default=0.01)"),
+    cl::init(0.01), cl::cat(SearchCat));
+
+cl::opt<bool> LearnedSearcherExportFeatures(
+    "learned-searcher-export-features",
+    cl::desc("Write the features and rewards observed by --search=learned to "
+             "searcher-features.csv (default=false)"),
+    cl::init(false), cl::cat(SearchCat));
+
 cl::opt<HaltExecution::Reason> UseIterativeDeepeningSearch(
     "use-iterative-deepening-search",
     cl::desc("Use iterative deepening search based on metric (experimental) "
@@ -86,6 +111,33 @@ cl::opt<std::string> BatchTime(
              "--use-batching-search.  Set to 0s to disable (default=5s)"),
     cl::init("5s"), cl::cat(SearchCat));
 
+cl::opt<bool> UseStateMerging(
+    "use-state-merging",
+    cl::desc("Pause states at the join points of symbolic branches and merge "
+             "them with sibling states arriving at the same point. Ignored "
+             "with guided search (default=false)"),
+    cl::init(false), cl::cat(SearchCat));
+
+cl::opt<unsigned> StateMergingMaxPause(
+    "state-merging-max-pause",
+    cl::desc("Number of instructions after which a state paused at a join "
+             "point is resumed without a merge partner when using "
+             "--use-state-merging.  Set to 0 to disable (default=10000)"),
+    cl::init(10000), cl::cat(SearchCat));
+
+cl::opt<bool> UseBatchStepping(
+    "use-batch-stepping",
+    cl::desc("Select batches of states and step each of them until it forks, "
+             "calls an external function or runs for --batch-instructions "
+             "instructions (see --batch-states) (default=false)"),
+    cl::init(false), cl::cat(SearchCat));
+
+cl::opt<unsigned> BatchStates(
+    "batch-states",
+    cl::desc("Maximal number of distinct states in a batch when using "
+             "--use-batch-stepping (default=4)"),
+    cl::init(4), cl::cat(SearchCat));
+
 cl::opt<bool> UseFairSearch(
     "use-fair-search",
     cl::desc(
@@ -113,11 +165,13 @@ bool klee::userSearcherRequiresMD2U() {
           std::find(CoreSearch.begin(), CoreSearch.end(),
                     Searcher::NURS_CPICnt) != CoreSearch.end() ||
           std::find(CoreSearch.begin(), CoreSearch.end(), Searcher::NURS_QC) !=
+              CoreSearch.end() ||
+          std::find(CoreSearch.begin(), CoreSearch.end(), Searcher::Learned) !=
               CoreSearch.end());
 }
 
 Searcher *getNewSearcher(Searcher::CoreSearchType type, RNG &rng,
-                         PForest &processForest) {
+                         PForest &processForest, InterpreterHandler &handler) {
   Searcher *searcher = nullptr;
   switch (type) {
   case Searcher::DFS:
@@ -132,6 +186,10 @@ Searcher *getNewSearcher(Searcher::CoreSearchType type, RNG &rng,
   case Searcher::RandomPath:
     searcher = new RandomPathSearcher(processForest, rng);
     break;
+  case Searcher::RandomPathStates:
+    searcher = new RandomPathSearcher(processForest, rng,
+                                      RandomPathSearcher::SubtreeSize);
+    break;
   case Searcher::NURS_CovNew:
     searcher =
         new WeightedRandomSearcher(WeightedRandomSearcher::CoveringNew, rng);
@@ -158,6 +216,19 @@ Searcher *getNewSearcher(Searcher::CoreSearchType type, RNG &rng,
     searcher =
         new WeightedRandomSearcher(WeightedRandomSearcher::QueryCost, rng);
     break;
+  case Searcher::Learned: {
+    std::unique_ptr<llvm::raw_ostream> featuresOS;
+    if (LearnedSearcherExportFeatures)
+      featuresOS = handler.openOutputFile("searcher-features.csv");
+    auto learned =
+        new LearnedSearcher(rng, LearnedSearcherRate, std::move(featuresOS));
+    std::string error;
+    if (!LearnedSearcherModel.empty() &&
+        !learned->loadModel(LearnedSearcherModel, error))
+      klee_error("Could not load learned searcher model: %s", error.c_str());
+    searcher = learned;
+    break;
+  }
   }
 
   return searcher;
@@ -165,7 +236,8 @@ Searcher *getNewSearcher(Searcher::CoreSearchType type, RNG &rng,
 
 Searcher *klee::constructBaseSearcher(Executor &executor) {
   Searcher *searcher =
-      getNewSearcher(CoreSearch[0], executor.theRNG, *executor.processForest);
+      getNewSearcher(CoreSearch[0], executor.theRNG, *executor.processForest,
+                     *executor.interpreterHandler);
 
   if (CoreSearch.size() > 1) {
     std::vector<Searcher *> s;
@@ -173,7 +245,8 @@ Searcher *klee::constructBaseSearcher(Executor &executor) {
 
     for (unsigned i = 1; i < CoreSearch.size(); i++)
       s.push_back(getNewSearcher(CoreSearch[i], executor.theRNG,
-                                 *executor.processForest));
+                                 *executor.processForest,
+                                 *executor.interpreterHandler));
 
     searcher = new InterleavedSearcher(s);
   }
@@ -181,6 +254,9 @@ Searcher *klee::constructBaseSearcher(Executor &executor) {
   if (UseBatchingSearch) {
     searcher = new BatchingSearcher(searcher, time::Span(BatchTime),
                                     BatchInstructions);
+  } else if (UseBatchStepping) {
+    searcher =
+        new BatchSteppingSearcher(searcher, BatchStates, BatchInstructions);
   }
 
   if (executor.guidanceKind != Interpreter::GuidanceKind::NoGuidance) {
@@ -206,6 +282,13 @@ Searcher *klee::constructUserSearcher(Executor &executor) {
     searcher = constructBaseSearcher(executor);
   }
 
+  if (UseStateMerging &&
+      executor.guidanceKind == Interpreter::GuidanceKind::NoGuidance) {
+    executor.mergingSearcher =
+        new MergingSearcher(searcher, StateMergingMaxPause);
+    searcher = executor.mergingSearcher;
+  }
+
   llvm::raw_ostream &os = executor.getHandler().getInfoStream();
 
   os << "BEGIN searcher description\n";
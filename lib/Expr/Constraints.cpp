@@ -398,8 +398,14 @@ PathConstraints::orderedCS() const {
   return orderedConstraints;
 }
 
+std::uint64_t PathConstraints::epoch() const { return _epoch; }
+
 void PathConstraints::advancePath(KInstruction *ki) { _path.advance(ki); }
 
+void PathConstraints::advancePath(const Path &path) {
+  _path = _path.KBlockSize() == 0 ? path : Path::concat(_path, path);
+}
+
 ExprHashSet PathConstraints::addConstraint(ref<Expr> e,
                                            Path::PathIndex currIndex) {
   auto expr = Simplificator::simplifyExpr(constraints, e);
@@ -449,10 +455,12 @@ bool PathConstraints::isSymcretized(ref<Expr> expr) const {
 
 void PathConstraints::addSymcrete(ref<Symcrete> s) {
   constraints.addSymcrete(s);
+  ++_epoch;
 }
 
 void PathConstraints::rewriteConcretization(const Assignment &a) {
   constraints.rewriteConcretization(a);
+  ++_epoch;
 }
 
 Simplificator::ExprResult
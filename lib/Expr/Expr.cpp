@@ -53,6 +53,13 @@ cl::opt<bool> ConstArrayOpt(
         "Enable an optimization involving all-constant arrays (default=false)"),
     cl::cat(klee::ExprCat));
 
+cl::opt<unsigned> MaxCachedConstants(
+    "max-cached-constants", cl::init(1 << 20),
+    cl::desc("Maximum number of constant expressions kept in the intern "
+             "table. Constants created once the table is full are not "
+             "interned (0=unlimited, default=1048576)"),
+    cl::cat(klee::ExprCat));
+
 cl::opt<bool>
     SingleReprForNaN("single-repr-for-nan", cl::init(true),
                      cl::desc("When constant folding produce a consistent bit "
@@ -595,6 +602,84 @@ ConstantExpr::~ConstantExpr() {
   }
 }
 
+namespace {
+/// Constants of the common integer widths within [SmallConstantMin,
+/// SmallConstantMax) (all values for Bool and Int8) are preallocated on first
+/// use and live until exit, so they never enter the intern table.
+const int64_t SmallConstantMin = -8;
+const int64_t SmallConstantMax = 256;
+const unsigned SmallConstantWidths = 5;
+const unsigned SmallConstantsPerWidth = SmallConstantMax - SmallConstantMin;
+} // namespace
+
+ConstantExpr *ConstantExpr::getSmallConstant(uint64_t v, Width w) {
+  static ref<ConstantExpr> table[SmallConstantWidths][SmallConstantsPerWidth];
+
+  unsigned row;
+  uint64_t index;
+  switch (w) {
+  case Expr::Bool:
+    row = 0;
+    index = v & 1;
+    break;
+  case Expr::Int8:
+    row = 1;
+    index = v & 0xFF;
+    break;
+  case Expr::Int16:
+  case Expr::Int32:
+  case Expr::Int64: {
+    row = w == Expr::Int16 ? 2 : w == Expr::Int32 ? 3 : 4;
+    unsigned shift = Expr::Int64 - w;
+    int64_t signedValue = static_cast<int64_t>(v << shift) >> shift;
+    if (signedValue < SmallConstantMin || signedValue >= SmallConstantMax)
+      return nullptr;
+    index = signedValue - SmallConstantMin;
+    break;
+  }
+  default:
+    return nullptr;
+  }
+
+  ref<ConstantExpr> &entry = table[row][index];
+  if (entry.isNull()) {
+    entry = new ConstantExpr(llvm::APInt(w, v));
+    entry->computeHash();
+    entry->computeHeight();
+    // Unique like interned constants, so Expr::equals can compare pointers.
+    // The intern table never holds these values, so erasing them from it in
+    // ~ConstantExpr is a no-op.
+    entry->isCached = true;
+  }
+  return entry.get();
+}
+
+std::size_t ConstantExpr::getNumCachedConstants() {
+  return cachedConstantExpressions.cache.size();
+}
+
+ref<ConstantExpr> ConstantExpr::alloc(const llvm::APInt &v) {
+  if (v.getBitWidth() <= Expr::Int64)
+    if (ConstantExpr *small =
+            getSmallConstant(v.getZExtValue(), v.getBitWidth()))
+      return small;
+
+  auto success = cachedConstantExpressions.cache.find(v);
+  if (success != cachedConstantExpressions.cache.end())
+    return success->second;
+
+  // Cache miss
+  ref<ConstantExpr> r = new ConstantExpr(v);
+  r->computeHash();
+  r->computeHeight();
+  if (MaxCachedConstants &&
+      cachedConstantExpressions.cache.size() >= MaxCachedConstants)
+    return r;
+  r->isCached = true;
+  cachedConstantExpressions.cache[v] = r.get();
+  return r;
+}
+
 Expr::ConstantExprCacheSet::~ConstantExprCacheSet() {
   while (cache.size() != 0) {
     auto tmp = *cache.begin();
@@ -1567,7 +1652,17 @@ ref<Expr> ReadExpr::create(const UpdateList &ul, ref<Expr> index, bool safe) {
   // array element has been updated
   auto un = ul.head.get();
   bool updateListHasSymbolicWrites = false;
+  const ConstantExpr *constantIndex = dyn_cast<ConstantExpr>(index);
+  if (constantIndex && constantIndex->getWidth() > 64)
+    constantIndex = nullptr;
   for (; un; un = un->next.get()) {
+    // Skip runs of writes at constant indices that cannot hit this index
+    while (constantIndex && un &&
+           !un->runMayWrite(constantIndex->getZExtValue())) {
+      un = un->getRunEnd();
+    }
+    if (!un)
+      break;
     ref<Expr> cond = EqExpr::create(index, un->index);
     if (ConstantExpr *CE = dyn_cast<ConstantExpr>(cond)) {
       if (CE->isTrue())
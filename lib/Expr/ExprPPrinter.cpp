@@ -370,7 +370,7 @@ public:
          << s->allocSite.getArgNo() << " " << s->index;
     } else if (auto s = dyn_cast<InstructionSource>(source)) {
       auto kf = s->km->functionMap.at(s->allocSite.getFunction());
-      auto ki = kf->instructionMap.at(&s->allocSite);
+      auto ki = kf->getInstructionMap().at(&s->allocSite);
       auto kb = ki->parent;
       PC << ki->getIndex() << " " << kb->getLabel() << " "
          << kf->getName().str() << " " << s->index;
@@ -13,6 +13,8 @@
 #include "klee/Expr/ExprVisitor.h"
 
 #include <set>
+#include <tuple>
+#include <unordered_map>
 
 using namespace klee;
 
@@ -304,3 +306,95 @@ klee::createNonOverflowingSumExpr(const std::vector<ref<Expr>> &terms) {
   }
   return sum;
 }
+
+namespace {
+/// Computes value bounds bottom-up, visiting every subexpression of a DAG
+/// once.
+class ValueBoundsComputer {
+  std::unordered_map<const Expr *, std::pair<uint64_t, uint64_t>> memo;
+
+  std::pair<uint64_t, uint64_t> compute(const ref<Expr> &e);
+
+public:
+  std::pair<uint64_t, uint64_t> get(const ref<Expr> &e) {
+    if (isa<ConstantExpr>(e) || e->getNumKids() == 0)
+      return compute(e);
+    auto it = memo.find(e.get());
+    if (it != memo.end())
+      return it->second;
+    auto bounds = compute(e);
+    memo.emplace(e.get(), bounds);
+    return bounds;
+  }
+};
+
+std::pair<uint64_t, uint64_t>
+ValueBoundsComputer::compute(const ref<Expr> &e) {
+  Expr::Width width = e->getWidth();
+  uint64_t widthMax =
+      width >= Expr::Int64 ? UINT64_MAX : bits64::maxValueOfNBits(width);
+  const std::pair<uint64_t, uint64_t> full(0, widthMax);
+  if (width > Expr::Int64)
+    return full;
+
+  uint64_t lmin, lmax, rmin, rmax;
+  auto getKidBounds = [&](const ref<Expr> &left, const ref<Expr> &right) {
+    std::tie(lmin, lmax) = get(left);
+    std::tie(rmin, rmax) = get(right);
+  };
+  auto getOperandBounds = [&]() {
+    const BinaryExpr *be = cast<BinaryExpr>(e);
+    getKidBounds(be->left, be->right);
+  };
+
+  switch (e->getKind()) {
+  case Expr::Constant: {
+    uint64_t value = cast<ConstantExpr>(e)->getZExtValue();
+    return {value, value};
+  }
+  case Expr::ZExt:
+    return get(cast<CastExpr>(e)->src);
+  case Expr::Select: {
+    const SelectExpr *se = cast<SelectExpr>(e);
+    getKidBounds(se->trueExpr, se->falseExpr);
+    return {std::min(lmin, rmin), std::max(lmax, rmax)};
+  }
+  case Expr::Add: {
+    getOperandBounds();
+    uint64_t sum;
+    if (!__builtin_add_overflow(lmax, rmax, &sum) && sum <= widthMax)
+      return {lmin + rmin, sum};
+    return full;
+  }
+  case Expr::Sub:
+    getOperandBounds();
+    if (lmin >= rmax)
+      return {lmin - rmax, lmax - rmin};
+    return full;
+  case Expr::Mul: {
+    getOperandBounds();
+    uint64_t product;
+    if (!__builtin_mul_overflow(lmax, rmax, &product) && product <= widthMax)
+      return {lmin * rmin, product};
+    return full;
+  }
+  case Expr::And:
+    getOperandBounds();
+    return {0, std::min(lmax, rmax)};
+  case Expr::UDiv:
+    getOperandBounds();
+    if (rmin > 0)
+      return {lmin / rmax, lmax / rmin};
+    return full;
+  case Expr::URem:
+    getOperandBounds();
+    return {0, rmax > 0 ? std::min(lmax, rmax - 1) : lmax};
+  default:
+    return full;
+  }
+}
+} // namespace
+
+std::pair<uint64_t, uint64_t> klee::getValueBounds(const ref<Expr> &e) {
+  return ValueBoundsComputer().get(e);
+}
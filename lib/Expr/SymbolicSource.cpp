@@ -167,12 +167,12 @@ int InstructionSource::internalCompare(const SymbolicSource &b) const {
   auto bfunction = ib.allocSite.getParent()->getParent();
   auto bkf = km->functionMap.at(bfunction);
 
-  if (kf->instructionMap[&allocSite]->getGlobalIndex() !=
-      bkf->instructionMap[&ib.allocSite]->getGlobalIndex()) {
-    return kf->instructionMap[&allocSite]->getGlobalIndex() <
-                   bkf->instructionMap[&ib.allocSite]->getGlobalIndex()
-               ? -1
-               : 1;
+  unsigned globalIndex =
+      kf->getInstructionMap().at(&allocSite)->getGlobalIndex();
+  unsigned bGlobalIndex =
+      bkf->getInstructionMap().at(&ib.allocSite)->getGlobalIndex();
+  if (globalIndex != bGlobalIndex) {
+    return globalIndex < bGlobalIndex ? -1 : 1;
   }
   return 0;
 }
@@ -194,9 +194,9 @@ unsigned InstructionSource::computeHash() {
   res =
       (res * SymbolicSource::MAGIC_HASH_CONSTANT) + km->getFunctionId(function);
   res = (res * SymbolicSource::MAGIC_HASH_CONSTANT) +
-        kf->blockMap[block]->getId();
+        kf->getBlockMap().at(block)->getId();
   res = (res * SymbolicSource::MAGIC_HASH_CONSTANT) +
-        kf->instructionMap[&allocSite]->getIndex();
+        kf->getInstructionMap().at(&allocSite)->getIndex();
   hashValue = res;
   return hashValue;
 }
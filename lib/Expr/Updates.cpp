@@ -9,7 +9,11 @@
 
 #include "klee/Expr/Expr.h"
 
+#include "klee/ADT/SparseStorage.h"
+#include "klee/Expr/SourceBuilder.h"
+
 #include <cassert>
+#include <unordered_set>
 
 using namespace klee;
 
@@ -27,6 +31,23 @@ UpdateNode::UpdateNode(const ref<UpdateNode> &_next, const ref<Expr> &_index,
   computeHash();
   computeHeight();
   size = next ? next->size + 1 : 1;
+
+  const ConstantExpr *constantIndex = dyn_cast<ConstantExpr>(index);
+  if (constantIndex && constantIndex->getWidth() <= 64) {
+    runMin = runMax = constantIndex->getZExtValue();
+    runEnd = nullptr;
+    if (next && next->runEnd == next.get()) {
+      runEnd = next.get();
+    } else if (next) {
+      runEnd = next->runEnd;
+      runMin = std::min(runMin, next->runMin);
+      runMax = std::max(runMax, next->runMax);
+    }
+  } else {
+    runEnd = this;
+    runMin = 1;
+    runMax = 0;
+  }
 }
 
 extern "C" void vc_DeleteExpr(void *);
@@ -69,6 +90,42 @@ void UpdateList::extend(const ref<Expr> &index, const ref<Expr> &value) {
   head = new UpdateNode(head, index, value);
 }
 
+bool UpdateList::compact() {
+  if (!root || !head || head->getRunEnd())
+    return false;
+  const auto *source = dyn_cast<ConstantSource>(root->source);
+  const auto *sizeExpr = dyn_cast<ConstantExpr>(root->size);
+  if (!source || !sizeExpr)
+    return false;
+
+  uint64_t arraySize = sizeExpr->getZExtValue();
+  std::unique_ptr<SparseStorage<ref<ConstantExpr>>> values(
+      source->constantValues->clone());
+  std::unordered_set<uint64_t> written;
+  std::vector<const UpdateNode *> symbolicWrites;
+  for (const auto *un = head.get(); un; un = un->next.get()) {
+    uint64_t index = cast<ConstantExpr>(un->index)->getZExtValue();
+    if (index >= arraySize)
+      return false;
+    // Older writes to the same index are shadowed
+    if (!written.insert(index).second)
+      continue;
+    if (ref<ConstantExpr> value = dyn_cast<ConstantExpr>(un->value))
+      values->store(index, value);
+    else
+      symbolicWrites.push_back(un);
+  }
+
+  const Array *compacted =
+      Array::create(root->size, SourceBuilder::constant(values.release()),
+                    root->getDomain(), root->getRange());
+  UpdateList result(compacted, nullptr);
+  for (auto it = symbolicWrites.rbegin(); it != symbolicWrites.rend(); ++it)
+    result.extend((*it)->index, (*it)->value);
+  *this = result;
+  return true;
+}
+
 int UpdateList::compare(const UpdateList &b) const {
   if (root->source != b.root->source)
     return root->source < b.root->source ? -1 : 1;
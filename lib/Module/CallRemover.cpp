@@ -16,11 +16,35 @@ using namespace llvm;
 
 char CallRemover::ID;
 
-bool CallRemover::runOnModule(llvm::Module &M) {
-  std::vector<std::string> badFuncs = {"llvm.dbg.declare", "llvm.dbg.label",
-                                       "llvm.dbg.value"};
+static const char *const badFuncs[] = {"llvm.dbg.declare", "llvm.dbg.label",
+                                      "llvm.dbg.value"};
 
-  for (const auto &f : badFuncs) {
+static bool isBadFunction(const Function *f) {
+  if (!f || !f->isDeclaration())
+    return false;
+  for (const char *name : badFuncs)
+    if (f->getName() == name)
+      return true;
+  return false;
+}
+
+bool CallRemover::runOnFunction(llvm::Function &F) {
+  bool changed = false;
+  for (auto &bb : F) {
+    for (auto it = bb.begin(), ie = bb.end(); it != ie;) {
+      auto CI = dyn_cast<CallInst>(&*it++);
+      if (CI && isBadFunction(CI->getCalledFunction())) {
+        assert(CI->use_empty() && "deleted function must have void result");
+        CI->eraseFromParent();
+        changed = true;
+      }
+    }
+  }
+  return changed;
+}
+
+bool CallRemover::doFinalization(llvm::Module &M) {
+  for (const char *f : badFuncs) {
     auto Declare = M.getFunction(f);
     if (!Declare)
       continue;
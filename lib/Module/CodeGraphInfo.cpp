@@ -15,6 +15,7 @@
 #include "klee/Support/CompilerWarning.h"
 DISABLE_WARNING_PUSH
 DISABLE_WARNING_DEPRECATED_DECLARATIONS
+#include "llvm/Analysis/PostDominators.h"
 #include "llvm/IR/CFG.h"
 DISABLE_WARNING_POP
 
@@ -79,7 +80,7 @@ void CodeGraphInfo::calculateDistance(KFunction *kf) {
   sort.push_back({kf, 0});
   while (!nodes.empty()) {
     auto currKF = nodes.front();
-    for (auto callBlock : currKF->kCallBlocks) {
+    for (auto callBlock : currKF->getKCallBlocks()) {
       for (auto calledFunction : callBlock->calledFunctions) {
         if (!calledFunction || calledFunction->function()->isDeclaration())
           continue;
@@ -96,6 +97,8 @@ void CodeGraphInfo::calculateDistance(KFunction *kf) {
 }
 
 void CodeGraphInfo::calculateBackwardDistance(KFunction *kf) {
+  // Callers are only known once every function has been built
+  kf->parent->materializeAll();
   auto &callMap = kf->parent->callMap;
   auto &bdist = functionBackwardDistance[kf];
   auto &bsort = functionSortedBackwardDistance[kf];
@@ -120,7 +123,7 @@ void CodeGraphInfo::calculateBackwardDistance(KFunction *kf) {
 
 void CodeGraphInfo::calculateFunctionBranches(KFunction *kf) {
   KBlockMap<std::set<unsigned>> &fbranches = functionBranches[kf];
-  for (auto &kb : kf->blocks) {
+  for (auto &kb : kf->getBlocks()) {
     fbranches[kb.get()];
     if (!isa<KCallBlock>(kb.get())) {
       for (unsigned branch = 0;
@@ -133,7 +136,7 @@ void CodeGraphInfo::calculateFunctionBranches(KFunction *kf) {
 }
 void CodeGraphInfo::calculateFunctionConditionalBranches(KFunction *kf) {
   KBlockMap<std::set<unsigned>> &fbranches = functionConditionalBranches[kf];
-  for (auto &kb : kf->blocks) {
+  for (auto &kb : kf->getBlocks()) {
     if (kb->basicBlock()->getTerminator()->getNumSuccessors() > 1) {
       fbranches[kb.get()];
       for (unsigned branch = 0;
@@ -146,11 +149,22 @@ void CodeGraphInfo::calculateFunctionConditionalBranches(KFunction *kf) {
 }
 void CodeGraphInfo::calculateFunctionBlocks(KFunction *kf) {
   KBlockMap<std::set<unsigned>> &fbranches = functionBlocks[kf];
-  for (auto &kb : kf->blocks) {
+  for (auto &kb : kf->getBlocks()) {
     fbranches[kb.get()];
   }
 }
 
+void CodeGraphInfo::calculatePostDominators(KFunction *kf) {
+  auto &ipdoms = functionPostDominators[kf];
+  llvm::PostDominatorTree pdt(*kf->function());
+  for (auto &kb : kf->getBlocks()) {
+    llvm::DomTreeNode *node = pdt.getNode(kb->basicBlock());
+    if (!node || !node->getIDom() || !node->getIDom()->getBlock())
+      continue;
+    ipdoms[kb.get()] = kf->getBlockMap().at(node->getIDom()->getBlock());
+  }
+}
+
 const BlockDistanceMap &CodeGraphInfo::getDistance(KBlock *b) {
   if (blockDistance.count(b) == 0)
     calculateDistance(b);
@@ -186,7 +200,7 @@ void CodeGraphInfo::getNearestPredicateSatisfying(KBlock *from,
                                                   KBlockSet &result) {
   std::unordered_set<KBlock *> visited;
 
-  auto blockMap = from->parent->blockMap;
+  const auto &blockMap = from->parent->getBlockMap();
   std::deque<KBlock *> nodes;
   nodes.push_back(from);
 
@@ -198,8 +212,8 @@ void CodeGraphInfo::getNearestPredicateSatisfying(KBlock *from,
       result.insert(currBB);
     } else {
       for (auto succ : successors(currBB->basicBlock())) {
-        if (visited.count(blockMap[succ]) == 0) {
-          nodes.push_back(blockMap[succ]);
+        if (visited.count(blockMap.at(succ)) == 0) {
+          nodes.push_back(blockMap.at(succ));
         }
       }
     }
@@ -227,3 +241,12 @@ CodeGraphInfo::getFunctionBlocks(KFunction *kf) {
     calculateFunctionBlocks(kf);
   return functionBlocks.at(kf);
 }
+
+KBlock *CodeGraphInfo::getImmediatePostDominator(KBlock *kb) {
+  KFunction *kf = kb->parent;
+  if (functionPostDominators.count(kf) == 0)
+    calculatePostDominators(kf);
+  auto &ipdoms = functionPostDominators.at(kf);
+  auto it = ipdoms.find(kb);
+  return it == ipdoms.end() ? nullptr : it->second;
+}
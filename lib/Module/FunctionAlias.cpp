@@ -19,6 +19,7 @@ DISABLE_WARNING_DEPRECATED_DECLARATIONS
 #include "llvm/IR/GlobalAlias.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Regex.h"
+#include "llvm/Support/raw_ostream.h"
 DISABLE_WARNING_POP
 
 using namespace llvm;
@@ -37,6 +38,11 @@ cl::list<std::string>
 
 namespace klee {
 
+void FunctionAliasPass::describeOptions(llvm::raw_ostream &os) {
+  for (const auto &pair : FunctionAlias)
+    os << "function-alias=" << pair << "\n";
+}
+
 bool FunctionAliasPass::runOnModule(Module &M) {
   bool modified = false;
 
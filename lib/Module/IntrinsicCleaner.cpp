@@ -40,17 +40,20 @@ namespace klee {
 
 char IntrinsicCleanerPass::ID;
 
-bool IntrinsicCleanerPass::runOnModule(Module &M) {
+bool IntrinsicCleanerPass::runOnFunction(Function &F) {
   bool dirty = false;
-  for (Module::iterator f = M.begin(), fe = M.end(); f != fe; ++f)
-    for (Function::iterator b = f->begin(), be = f->end(); b != be; ++b)
-      dirty |= runOnBasicBlock(*b, M);
+  for (Function::iterator b = F.begin(), be = F.end(); b != be; ++b)
+    dirty |= runOnBasicBlock(*b, *F.getParent());
+  return dirty;
+}
 
+bool IntrinsicCleanerPass::doFinalization(Module &M) {
+  // All calls to llvm.trap have been replaced by now
   if (Function *Declare = M.getFunction("llvm.trap")) {
     Declare->eraseFromParent();
-    dirty = true;
+    return true;
   }
-  return dirty;
+  return false;
 }
 
 bool IntrinsicCleanerPass::runOnBasicBlock(BasicBlock &b, Module &M) {
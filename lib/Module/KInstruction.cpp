@@ -45,35 +45,93 @@ static int getOperandNum(
   }
 }
 
-KInstruction::KInstruction(
-    const std::unordered_map<llvm::Instruction *, unsigned>
-        &_instructionToRegisterMap,
-    llvm::Instruction *_inst, KModule *_km, KBlock *_kb,
-    unsigned &_globalIndexInc)
+static KInstruction::ConcreteOp decodeConcreteOp(const Instruction &inst) {
+  using Op = KInstruction::ConcreteOp;
+  if (const auto *cmp = dyn_cast<ICmpInst>(&inst)) {
+    switch (cmp->getPredicate()) {
+    case ICmpInst::ICMP_EQ:
+      return Op::ICmpEQ;
+    case ICmpInst::ICMP_NE:
+      return Op::ICmpNE;
+    case ICmpInst::ICMP_UGT:
+      return Op::ICmpUGT;
+    case ICmpInst::ICMP_UGE:
+      return Op::ICmpUGE;
+    case ICmpInst::ICMP_ULT:
+      return Op::ICmpULT;
+    case ICmpInst::ICMP_ULE:
+      return Op::ICmpULE;
+    case ICmpInst::ICMP_SGT:
+      return Op::ICmpSGT;
+    case ICmpInst::ICMP_SGE:
+      return Op::ICmpSGE;
+    case ICmpInst::ICMP_SLT:
+      return Op::ICmpSLT;
+    case ICmpInst::ICMP_SLE:
+      return Op::ICmpSLE;
+    default:
+      return Op::None;
+    }
+  }
+
+  if (inst.getType()->isVectorTy())
+    return Op::None;
+
+  // Divisions and shifts keep their error checks on the generic path
+  switch (inst.getOpcode()) {
+  case Instruction::Add:
+    return Op::Add;
+  case Instruction::Sub:
+    return Op::Sub;
+  case Instruction::Mul:
+    return Op::Mul;
+  case Instruction::And:
+    return Op::And;
+  case Instruction::Or:
+    return Op::Or;
+  case Instruction::Xor:
+    return Op::Xor;
+  default:
+    return Op::None;
+  }
+}
+
+KInstruction::KInstruction(llvm::Instruction *_inst, KBlock *_kb,
+                           unsigned &_globalIndexInc)
     : KValue(_inst, KValue::Kind::INSTRUCTION), parent(_kb),
-      globalIndex(_globalIndexInc++) {
+      globalIndex(_globalIndexInc++), opcode(_inst->getOpcode()),
+      concreteOp(decodeConcreteOp(*_inst)) {}
+
+unsigned KInstruction::getNumOperandSlots(const llvm::Instruction &inst) {
+  if (isa<llvm::CallInst>(inst) || isa<llvm::InvokeInst>(inst))
+    return cast<llvm::CallBase>(inst).arg_size() + 1;
+  return inst.getNumOperands();
+}
+
+void KInstruction::setOperands(
+    int *slots,
+    const std::unordered_map<llvm::Instruction *, unsigned>
+        &instructionToRegisterMap,
+    KModule *km) {
+  operands = slots;
   if (isa<llvm::CallInst>(inst()) || isa<llvm::InvokeInst>(inst())) {
     const llvm::CallBase &cs = cast<llvm::CallBase>(*inst());
     Value *val = cs.getCalledOperand();
     unsigned numArgs = cs.arg_size();
-    operands = new int[numArgs + 1];
-    operands[0] = getOperandNum(val, _instructionToRegisterMap, _km, this);
+    operands[0] = getOperandNum(val, instructionToRegisterMap, km, this);
     for (unsigned j = 0; j < numArgs; j++) {
       Value *v = cs.getArgOperand(j);
-      operands[j + 1] = getOperandNum(v, _instructionToRegisterMap, _km, this);
+      operands[j + 1] = getOperandNum(v, instructionToRegisterMap, km, this);
     }
   } else {
     unsigned numOperands = inst()->getNumOperands();
-    operands = new int[numOperands];
     for (unsigned j = 0; j < numOperands; j++) {
       Value *v = inst()->getOperand(j);
-      operands[j] = getOperandNum(v, _instructionToRegisterMap, _km, this);
+      operands[j] = getOperandNum(v, instructionToRegisterMap, km, this);
     }
   }
 }
 
-KInstruction::~KInstruction() { delete[] operands; }
-
 size_t KInstruction::getLine() const {
   auto locationInfo = getLocationInfo(inst());
   return locationInfo.line;
@@ -113,8 +171,7 @@ unsigned KInstruction::getIndex() const {
 }
 
 unsigned KInstruction::getDest() const {
-  return parent->parent->getNumArgs() + getIndex() +
-         (parent->instructions - parent->parent->instructions);
+  return parent->parent->getNumArgs() + getIndex() + parent->getId();
 }
 
 KInstruction::Index KInstruction::getID() const {
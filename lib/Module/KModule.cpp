@@ -11,6 +11,7 @@
 
 #include "Passes.h"
 
+#include "klee/Config/CompileTimeInfo.h"
 #include "klee/Config/Version.h"
 #include "klee/Core/Interpreter.h"
 #include "klee/Module/Cell.h"
@@ -25,6 +26,8 @@
 #include "klee/Support/CompilerWarning.h"
 DISABLE_WARNING_PUSH
 DISABLE_WARNING_DEPRECATED_DECLARATIONS
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/IR/AssemblyAnnotationWriter.h"
 #include "llvm/IR/CFG.h"
@@ -35,12 +38,16 @@ DISABLE_WARNING_DEPRECATED_DECLARATIONS
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Module.h"
+#include "llvm/IR/ModuleSlotTracker.h"
 #include "llvm/IR/ValueSymbolTable.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/Linker/Linker.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/FormattedStream.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/SHA1.h"
 #include "llvm/Support/raw_os_ostream.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/Scalar.h"
@@ -91,6 +98,26 @@ cl::opt<bool> DebugPrintEscapingFunctions(
     cl::desc("Print functions whose address is taken (default=false)"),
     cl::cat(ModuleCat));
 
+cl::opt<bool> MatchIndirectCallSignatures(
+    "match-indirect-call-signatures",
+    cl::desc("Only consider escaping functions with a compatible signature "
+             "as targets of indirect calls in the call graph (default=true)"),
+    cl::init(true), cl::cat(ModuleCat));
+
+cl::opt<bool> WriteFunctionHashes(
+    "write-function-hashes",
+    cl::desc("Write a structural hash of each function of the final module "
+             "to function-hashes.txt (default=false)"),
+    cl::init(false), cl::cat(ModuleCat));
+
+cl::opt<std::string> ChangedSince(
+    "changed-since",
+    cl::desc("Compare the functions against a function-hashes.txt written by "
+             "an earlier run and treat the unchanged ones as covered, so that "
+             "coverage-guided search and test generation focus on changed "
+             "code (default=off)"),
+    cl::init(""), cl::cat(ModuleCat));
+
 // For testing rounding mode only
 cl::opt<bool> UseKleeFloatInternals(
     "float-internals",
@@ -127,12 +154,19 @@ cl::opt<bool> SplitReturns(
     "split-returns",
     cl::desc("Split each return in own basic block (default=true)"),
     cl::init(true), cl::cat(klee::ModuleCat));
+
+cl::opt<bool> LazyFunctions(
+    "lazy-kfunctions",
+    cl::desc("Build the blocks and instructions of a function only when it "
+             "is first used (default=true)"),
+    cl::init(true), cl::cat(klee::ModuleCat));
 } // namespace
 
 /***/
 
 namespace llvm {
 extern void Optimize(Module *, llvm::ArrayRef<const char *> preservedFunctions);
+extern void DescribeOptimizeOptions(raw_ostream &os);
 }
 
 // what a hack
@@ -221,6 +255,61 @@ void KModule::addInternalFunction(const char *functionName) {
   internalFunctions.insert(internalFunction);
 }
 
+void KModule::addInternalCheckFunctions(
+    const Interpreter::ModuleOptions &opts) {
+  // Add internal functions which are not used to check if instructions
+  // have been already visited
+  if (opts.CheckDivZero)
+    addInternalFunction("klee_div_zero_check");
+  if (opts.CheckOvershift)
+    addInternalFunction("klee_overshift_check");
+}
+
+void KModule::addCallBlocks(KFunction *kf) {
+  for (auto kcb : kf->getKCallBlocks()) {
+    bool isInlineAsm = false;
+    const CallBase &cs = cast<CallBase>(*kcb->kcallInstruction->inst());
+    Value *fp = cs.getCalledOperand();
+    Function *f = getTargetFunction(fp);
+    if (f) {
+      auto target = functionMap.find(getTargetFunction(fp));
+      if (target != functionMap.end()) {
+        kcb->calledFunctions.insert(target->second);
+      }
+    }
+    if (isa<InlineAsm>(cs.getCalledOperand())) {
+      isInlineAsm = true;
+    }
+    if (kcb->calledFunctions.empty() && !isInlineAsm &&
+        (guidance != Interpreter::GuidanceKind::ErrorGuidance ||
+         !inMainModule(*kf->function()))) {
+      getIndirectCallTargets(cs, kcb->calledFunctions);
+    }
+    for (auto calledFunction : kcb->calledFunctions) {
+      callMap[calledFunction].insert(kf);
+    }
+  }
+
+  if (onMaterialize)
+    onMaterialize(kf);
+}
+
+void KModule::getIndirectCallTargets(const CallBase &cb,
+                                     KFunctionSet &targets) const {
+  if (MatchIndirectCallSignatures) {
+    bool found = false;
+    for (auto kf : escapingFunctions) {
+      if (isCompatibleIndirectCallTarget(cb, *kf->function())) {
+        targets.insert(kf);
+        found = true;
+      }
+    }
+    if (found)
+      return;
+  }
+  targets.insert(escapingFunctions.begin(), escapingFunctions.end());
+}
+
 bool KModule::link(std::vector<std::unique_ptr<llvm::Module>> &modules,
                    unsigned flags) {
   std::string error;
@@ -264,6 +353,103 @@ void KModule::instrument(const Interpreter::ModuleOptions &opts) {
   withPosixRuntime = opts.WithPOSIXRuntime;
 }
 
+std::string
+KModule::getPreparedModuleKey(llvm::ArrayRef<const llvm::Module *> modules,
+                              llvm::ArrayRef<llvm::StringRef> extra,
+                              const Interpreter::ModuleOptions &opts) {
+  SHA1 hasher;
+  // Prefix every input with its length so that different splits of the
+  // same bytes do not collide
+  auto addInput = [&hasher](StringRef data) {
+    hasher.update(utostr(data.size()) + ":");
+    hasher.update(data);
+  };
+
+  SmallVector<char, 0> bitcode;
+  for (const llvm::Module *m : modules) {
+    bitcode.clear();
+    raw_svector_ostream os(bitcode);
+    WriteBitcodeToFile(*m, os);
+    addInput(StringRef(bitcode.data(), bitcode.size()));
+  }
+  for (StringRef data : extra)
+    addInput(data);
+
+  std::string options;
+  raw_string_ostream os(options);
+  os << PACKAGE_STRING << " " << KLEE_BUILD_REVISION << "\n"
+     << opts.LibraryDir << "\n"
+     << opts.EntryPoint << "\n"
+     << opts.OptSuffix << "\n"
+     << opts.MainCurrentName << "\n"
+     << opts.MainNameAfterMock << "\n"
+     << opts.AnnotationsFile << "\n"
+     << opts.Optimize << opts.Simplify << opts.CheckDivZero
+     << opts.CheckOvershift << opts.AnnotateOnlyExternal << opts.WithFPRuntime
+     << opts.WithPOSIXRuntime << "\n"
+     << "switch-type=" << SwitchType
+     << " float-internals=" << UseKleeFloatInternals
+     << " klee-call-optimisation=" << OptimiseKLEECall
+     << " strip-unwanted-calls=" << StripUnwantedCalls
+     << " split-calls=" << SplitCalls << " split-returns=" << SplitReturns
+     << "\n";
+  DescribeOptimizeOptions(os);
+  FunctionAliasPass::describeOptions(os);
+  addInput(os.str());
+
+  return toHex(hasher.final(), /*LowerCase=*/true);
+}
+
+bool KModule::loadPreparedModule(const std::string &path,
+                                 llvm::LLVMContext &ctx,
+                                 const Interpreter::ModuleOptions &opts) {
+  auto buffer = MemoryBuffer::getFile(path);
+  if (!buffer)
+    return false;
+
+  auto loaded = parseBitcodeFile(buffer.get()->getMemBufferRef(), ctx);
+  if (!loaded) {
+    klee_warning("Ignoring prepared module %s: %s", path.c_str(),
+                 toString(loaded.takeError()).c_str());
+    return false;
+  }
+
+  module = std::move(loaded.get());
+  targetData = std::make_unique<llvm::DataLayout>(module.get());
+  withPosixRuntime = opts.WithPOSIXRuntime;
+  addInternalCheckFunctions(opts);
+  return true;
+}
+
+void KModule::storePreparedModule(const std::string &path) const {
+  // Write to a temporary file first, so that concurrent runs never load a
+  // partially written module
+  SmallString<128> directory(path);
+  sys::path::remove_filename(directory);
+  if (auto ec = sys::fs::create_directories(directory)) {
+    klee_warning("Unable to create prepared module cache %s: %s",
+                 directory.c_str(), ec.message().c_str());
+    return;
+  }
+
+  int fd;
+  SmallString<128> tempPath;
+  if (auto ec = sys::fs::createUniqueFile(path + ".%%%%%%.tmp", fd, tempPath)) {
+    klee_warning("Unable to store prepared module %s: %s", path.c_str(),
+                 ec.message().c_str());
+    return;
+  }
+  {
+    raw_fd_ostream os(fd, /*shouldClose=*/true);
+    WriteBitcodeToFile(*module, os);
+  }
+  if (auto ec = sys::fs::rename(tempPath, path)) {
+    klee_warning("Unable to store prepared module %s: %s", path.c_str(),
+                 ec.message().c_str());
+    sys::fs::remove(tempPath);
+  }
+}
+
 void KModule::optimiseAndPrepare(
     const Interpreter::ModuleOptions &opts,
     llvm::ArrayRef<const char *> preservedFunctions) {
@@ -288,12 +474,7 @@ void KModule::optimiseAndPrepare(
   if (opts.Optimize)
     Optimize(module.get(), preservedFunctions);
 
-  // Add internal functions which are not used to check if instructions
-  // have been already visited
-  if (opts.CheckDivZero)
-    addInternalFunction("klee_div_zero_check");
-  if (opts.CheckOvershift)
-    addInternalFunction("klee_overshift_check");
+  addInternalCheckFunctions(opts);
 
   // Needs to happen after linking (since ctors/dtors can be modified)
   // and optimization (since global optimization can rewrite lists).
@@ -304,6 +485,10 @@ void KModule::optimiseAndPrepare(
   // linked in something with intrinsics but any external calls are
   // going to be unresolved. We really need to handle the intrinsics
   // directly I think?
+  //
+  // FunctionAliasPass is the only module pass. The function passes before
+  // and after it each run as one pipeline per function instead of sweeping
+  // over the whole module once per pass.
   legacy::PassManager pm3;
 
   pm3.add(new ReturnLocationFinderPass());
@@ -338,36 +523,157 @@ void KModule::optimiseAndPrepare(
   pm3.run(*module);
 }
 
+/// Hash the structure of a function: its type and, for each instruction,
+/// the opcode, the types and the operands. Local values are identified by
+/// their position and global values by their name, so that the hash does
+/// not depend on value names, debug information or other functions.
+static std::string hashFunction(const llvm::Function &f,
+                                llvm::ModuleSlotTracker &mst) {
+  llvm::DenseMap<const llvm::Value *, unsigned> locals;
+  for (auto &arg : f.args())
+    locals.insert({&arg, locals.size()});
+  for (auto &bb : f) {
+    locals.insert({&bb, locals.size()});
+    for (auto &inst : bb)
+      locals.insert({&inst, locals.size()});
+  }
+
+  std::string text;
+  llvm::raw_string_ostream os(text);
+  auto printOperand = [&](const llvm::Value *v) {
+    os << ' ';
+    auto local = locals.find(v);
+    if (local != locals.end())
+      os << '%' << local->second;
+    else if (isa<MetadataAsValue>(v))
+      os << "metadata";
+    else
+      v->printAsOperand(os, /*PrintType=*/true, mst);
+  };
+
+  f.getFunctionType()->print(os);
+  for (auto &bb : f) {
+    os << "\nblock";
+    for (auto &inst : bb) {
+      os << '\n' << inst.getOpcodeName() << ' ';
+      inst.getType()->print(os);
+      for (const llvm::Value *op : inst.operand_values())
+        printOperand(op);
+
+      // Parts of an instruction that are not operands
+      if (auto cmp = dyn_cast<CmpInst>(&inst)) {
+        os << " pred " << cmp->getPredicate();
+      } else if (auto phi = dyn_cast<PHINode>(&inst)) {
+        for (auto block : phi->blocks())
+          printOperand(block);
+      } else if (auto alloca = dyn_cast<AllocaInst>(&inst)) {
+        os << ' ';
+        alloca->getAllocatedType()->print(os);
+      } else if (auto gep = dyn_cast<GetElementPtrInst>(&inst)) {
+        os << ' ';
+        gep->getSourceElementType()->print(os);
+      } else if (auto ev = dyn_cast<ExtractValueInst>(&inst)) {
+        for (unsigned index : ev->indices())
+          os << ' ' << index;
+      } else if (auto iv = dyn_cast<InsertValueInst>(&inst)) {
+        for (unsigned index : iv->indices())
+          os << ' ' << index;
+      } else if (auto sv = dyn_cast<ShuffleVectorInst>(&inst)) {
+        for (int index : sv->getShuffleMask())
+          os << ' ' << index;
+      } else if (auto call = dyn_cast<CallBase>(&inst)) {
+        os << ' ';
+        call->getFunctionType()->print(os);
+      }
+    }
+  }
+
+  SHA1 hasher;
+  hasher.update(os.str());
+  return toHex(hasher.final(), /*LowerCase=*/true);
+}
+
+/// Write the hash of every defined function and, if --changed-since is
+/// given, collect the functions whose hash did not change since then.
+static void compareFunctionHashes(KModule &km, InterpreterHandler *ih) {
+  llvm::ModuleSlotTracker mst(km.module.get(),
+                              /*ShouldInitializeAllMetadata=*/false);
+  std::unique_ptr<llvm::raw_fd_ostream> out;
+  if (WriteFunctionHashes)
+    out = ih->openOutputFile("function-hashes.txt");
+
+  std::unordered_map<std::string, std::string> previous;
+  if (!ChangedSince.empty()) {
+    auto buffer = MemoryBuffer::getFile(ChangedSince);
+    if (!buffer)
+      klee_error("Could not read function hashes from %s: %s",
+                 ChangedSince.c_str(), buffer.getError().message().c_str());
+    SmallVector<StringRef, 0> lines;
+    (*buffer)->getBuffer().split(lines, '\n', -1, /*KeepEmpty=*/false);
+    for (StringRef line : lines) {
+      auto hashAndName = line.split(' ');
+      previous[hashAndName.second.str()] = hashAndName.first.str();
+    }
+  }
+
+  unsigned numDefined = 0;
+  for (auto &kf : km.functions) {
+    const llvm::Function &f = *kf->function();
+    if (f.isDeclaration())
+      continue;
+    ++numDefined;
+    std::string hash = hashFunction(f, mst);
+    if (out)
+      *out << hash << ' ' << f.getName() << '\n';
+    auto it = previous.find(f.getName().str());
+    if (it != previous.end() && it->second == hash)
+      km.unchangedFunctions.insert(kf.get());
+  }
+
+  if (!ChangedSince.empty())
+    klee_message("%zu of %u functions changed since %s",
+                 numDefined - km.unchangedFunctions.size(), numDefined,
+                 ChangedSince.c_str());
+}
+
+/// Records the line of each function and instruction while the module is
+/// printed. Instructions are printed in function order, so their global
+/// indices follow from their position and no function has to be built.
 class InstructionToLineAnnotator : public llvm::AssemblyAnnotationWriter {
 private:
-  std::unordered_map<uintptr_t, uint64_t> mapping = {};
+  const KModule &km;
+  std::vector<uint32_t> &lines;
+  const KFunction *current = nullptr;
+  unsigned position = 0;
 
 public:
+  InstructionToLineAnnotator(const KModule &km, std::vector<uint32_t> &lines)
+      : km(km), lines(lines) {}
+
   void emitInstructionAnnot(const llvm::Instruction *i,
                             llvm::formatted_raw_ostream &os) override {
+    assert(current && current->function() == i->getFunction());
     os.flush();
-    mapping.emplace(reinterpret_cast<std::uintptr_t>(i), os.getLine() + 1);
+    lines[current->getInstructionGlobalIndex(position++)] = os.getLine() + 1;
   }
 
   void emitFunctionAnnot(const llvm::Function *f,
                          llvm::formatted_raw_ostream &os) override {
     os.flush();
-    mapping.emplace(reinterpret_cast<std::uintptr_t>(f), os.getLine() + 1);
+    current = km.functionMap.at(f);
+    position = 0;
+    lines[current->getGlobalIndex()] = os.getLine() + 1;
   }
-
-  std::unordered_map<uintptr_t, uint64_t> getMapping() const { return mapping; }
 };
 
-static std::unordered_map<uintptr_t, uint64_t>
-buildInstructionToLineMap(const llvm::Module &m,
+static void
+buildInstructionToLineMap(const KModule &km, std::vector<uint32_t> &lines,
                           std::unique_ptr<llvm::raw_fd_ostream> assemblyFS) {
+  lines.assign(km.getMaxGlobalIndex(), 0);
+  InstructionToLineAnnotator a(km, lines);
 
-  InstructionToLineAnnotator a;
-
-  m.print(*assemblyFS, &a);
+  km.module->print(*assemblyFS, &a);
   assemblyFS->flush();
-
-  return a.getMapping();
 }
 
 void KModule::manifest(InterpreterHandler *ih,
@@ -379,15 +685,6 @@ void KModule::manifest(InterpreterHandler *ih,
     WriteBitcodeToFile(*module, *f);
   }
 
-  {
-    /* Build shadow structures */
-    std::unique_ptr<llvm::raw_fd_ostream> assemblyFS;
-    if (OutputSource || forceSourceOutput) {
-      assemblyFS = ih->openOutputFile("assembly.ll");
-      asmLineMap = buildInstructionToLineMap(*module, std::move(assemblyFS));
-    }
-  }
-
   std::vector<KFunction *> declarations;
 
   unsigned functionID = 0;
@@ -406,6 +703,11 @@ void KModule::manifest(InterpreterHandler *ih,
     functions.push_back(std::move(kf));
   }
 
+  if (OutputSource || forceSourceOutput) {
+    buildInstructionToLineMap(*this, asmLines,
+                              ih->openOutputFile("assembly.ll"));
+  }
+
   unsigned globalID = 0;
   for (auto &global : module->globals()) {
     globalMap.emplace(&global, new KGlobalVariable(&global, globalID++));
@@ -424,32 +726,12 @@ void KModule::manifest(InterpreterHandler *ih,
       escapingFunctions.insert(declaration);
   }
 
-  for (auto &kfp : functions) {
-    for (auto kcb : kfp->kCallBlocks) {
-      bool isInlineAsm = false;
-      const CallBase &cs = cast<CallBase>(*kcb->kcallInstruction->inst());
-      Value *fp = cs.getCalledOperand();
-      Function *f = getTargetFunction(fp);
-      if (f) {
-        auto kf = functionMap.find(getTargetFunction(fp));
-        if (kf != functionMap.end()) {
-          kcb->calledFunctions.insert(kf->second);
-        }
-      }
-      if (isa<InlineAsm>(cs.getCalledOperand())) {
-        isInlineAsm = true;
-      }
-      if (kcb->calledFunctions.empty() && !isInlineAsm &&
-          (guidance != Interpreter::GuidanceKind::ErrorGuidance ||
-           !inMainModule(*kfp->function()))) {
-        kcb->calledFunctions.insert(escapingFunctions.begin(),
-                                    escapingFunctions.end());
-      }
-      for (auto calledFunction : kcb->calledFunctions) {
-        callMap[calledFunction].insert(kfp.get());
-      }
-    }
-  }
+  if (WriteFunctionHashes || !ChangedSince.empty())
+    compareFunctionHashes(*this, ih);
+
+  this->guidance = guidance;
+  if (!LazyFunctions)
+    materializeAll();
 
   if (DebugPrintEscapingFunctions && !escapingFunctions.empty()) {
     llvm::errs() << "KLEE: escaping functions: [";
@@ -462,17 +744,17 @@ void KModule::manifest(InterpreterHandler *ih,
   }
 }
 
-std::optional<size_t> KModule::getAsmLine(const uintptr_t ref) const {
-  if (!asmLineMap.empty()) {
-    return asmLineMap.at(ref);
+std::optional<size_t> KModule::getAsmLine(unsigned globalIndex) const {
+  if (!asmLines.empty()) {
+    return asmLines.at(globalIndex);
   }
   return std::nullopt;
 }
 std::optional<size_t> KModule::getAsmLine(const llvm::Function *func) const {
-  return getAsmLine(reinterpret_cast<std::uintptr_t>(func));
+  return getAsmLine(functionMap.at(func)->getGlobalIndex());
 }
-std::optional<size_t> KModule::getAsmLine(const llvm::Instruction *inst) const {
-  return getAsmLine(reinterpret_cast<std::uintptr_t>(inst));
+std::optional<size_t> KModule::getAsmLine(const KInstruction *ki) const {
+  return getAsmLine(ki->getGlobalIndex());
 }
 
 void KModule::checkModule() {
@@ -494,7 +776,12 @@ void KModule::checkModule() {
 }
 
 KBlock *KModule::getKBlock(const llvm::BasicBlock *bb) {
-  return functionMap[bb->getParent()]->blockMap[bb];
+  return functionMap[bb->getParent()]->getBlockMap().at(bb);
+}
+
+void KModule::materializeAll() {
+  for (auto &kf : functions)
+    kf->materialize();
 }
 
 bool KModule::inMainModule(const llvm::Function &f) {
@@ -563,7 +850,8 @@ unsigned KModule::getGlobalIndex(const llvm::Function *func) const {
 }
 unsigned KModule::getGlobalIndex(const llvm::Instruction *inst) const {
   return functionMap.at(inst->getFunction())
-      ->instructionMap.at(inst)
+      ->getInstructionMap()
+      .at(inst)
       ->getGlobalIndex();
 }
 
@@ -606,10 +894,19 @@ unsigned KGlobalVariable::hash() const {
 KFunction::KFunction(llvm::Function *_function, KModule *_km,
                      unsigned &globalIndexInc)
     : KCallable(_function, Kind::FUNCTION), globalIndex(globalIndexInc++),
-      parent(_km), entryKBlock(nullptr), numInstructions(0) {
+      parent(_km), numInstructions(0) {
   for (auto &BasicBlock : *function()) {
     numInstructions += BasicBlock.size();
   }
+  // Reserve the global indices of all instructions
+  globalIndexInc += numInstructions;
+}
+
+void KFunction::build() const {
+  materialized = true;
+  auto self = const_cast<KFunction *>(this);
+  unsigned globalIndexInc = globalIndex + 1;
+
   instructions = new KInstruction *[numInstructions];
   std::unordered_map<Instruction *, unsigned> instructionToRegisterMap;
   // Assign unique instruction IDs to each basic block
@@ -629,17 +926,15 @@ KFunction::KFunction(llvm::Function *_function, KModule *_km,
     Instruction *fit = &bbit->front();
     Instruction *lit = &bbit->back();
     if (SplitCalls && (isa<CallInst>(fit) || isa<InvokeInst>(fit))) {
-      auto *ckb = new KCallBlock(this, &*bbit, parent, instructionToRegisterMap,
-                                 &instructions[n], globalIndexInc);
+      auto *ckb =
+          new KCallBlock(self, &*bbit, &instructions[n], globalIndexInc);
       kCallBlocks.push_back(ckb);
       kb = ckb;
     } else if (SplitReturns && isa<ReturnInst>(lit)) {
-      kb = new KReturnBlock(this, &*bbit, parent, instructionToRegisterMap,
-                            &instructions[n], globalIndexInc);
+      kb = new KReturnBlock(self, &*bbit, &instructions[n], globalIndexInc);
       returnKBlocks.push_back(kb);
     } else {
-      kb = new KBasicBlock(this, &*bbit, parent, instructionToRegisterMap,
-                           &instructions[n], globalIndexInc);
+      kb = new KBasicBlock(self, &*bbit, &instructions[n], globalIndexInc);
     }
     for (unsigned i = 0, ie = kb->getNumInstructions(); i < ie; i++, n++) {
       instructionMap[instructions[n]->inst()] = instructions[n];
@@ -647,11 +942,27 @@ KFunction::KFunction(llvm::Function *_function, KModule *_km,
     blockMap[&*bbit] = kb;
     blocks.push_back(std::unique_ptr<KBlock>(kb));
   }
+  assert(globalIndexInc == globalIndex + 1 + numInstructions);
+
+  // Store the operands of all instructions in one contiguous table, in
+  // instruction order
+  unsigned numOperandSlots = 0;
+  for (unsigned i = 0; i < numInstructions; ++i)
+    numOperandSlots +=
+        KInstruction::getNumOperandSlots(*instructions[i]->inst());
+  operandTable.reset(new int[numOperandSlots]);
+  int *slots = operandTable.get();
+  for (unsigned i = 0; i < numInstructions; ++i) {
+    instructions[i]->setOperands(slots, instructionToRegisterMap, parent);
+    slots += KInstruction::getNumOperandSlots(*instructions[i]->inst());
+  }
 
   if (blocks.size() > 0) {
     assert(function()->begin() != function()->end());
     entryKBlock = blockMap[&*function()->begin()];
   }
+
+  parent->addCallBlocks(self);
 }
 
 size_t KFunction::getLine() const {
@@ -665,6 +976,8 @@ std::string KFunction::getSourceFilepath() const {
 }
 
 KFunction::~KFunction() {
+  if (!materialized)
+    return;
   for (unsigned i = 0; i < numInstructions; ++i)
     delete instructions[i];
   delete[] instructions;
@@ -681,11 +994,9 @@ bool KFunctionCompare::operator()(const KFunction *a,
   return a->getGlobalIndex() < b->getGlobalIndex();
 }
 
-KBlock::KBlock(
-    KFunction *_kfunction, llvm::BasicBlock *block, KModule *km,
-    const std::unordered_map<Instruction *, unsigned> &instructionToRegisterMap,
-    KInstruction **instructionsKF, unsigned &globalIndexInc,
-    KBlockType blockType)
+KBlock::KBlock(KFunction *_kfunction, llvm::BasicBlock *block,
+               KInstruction **instructionsKF, unsigned &globalIndexInc,
+               KBlockType blockType)
     : KValue(block, KValue::Kind::BLOCK), blockKind(blockType),
       parent(_kfunction) {
   instructions = instructionsKF;
@@ -697,12 +1008,10 @@ KBlock::KBlock(
     case Instruction::GetElementPtr:
     case Instruction::InsertValue:
     case Instruction::ExtractValue:
-      ki = new KGEPInstruction(instructionToRegisterMap, &it, km, this,
-                               globalIndexInc);
+      ki = new KGEPInstruction(&it, this, globalIndexInc);
       break;
     default:
-      ki = new KInstruction(instructionToRegisterMap, &it, km, this,
-                            globalIndexInc);
+      ki = new KInstruction(&it, this, globalIndexInc);
       break;
     }
     instructions[ki->getIndex()] = ki;
@@ -726,12 +1035,10 @@ unsigned KBlock::hash() const {
   return getGlobalIndex();
 }
 
-KCallBlock::KCallBlock(
-    KFunction *_kfunction, llvm::BasicBlock *block, KModule *km,
-    const std::unordered_map<Instruction *, unsigned> &instructionToRegisterMap,
-    KInstruction **instructionsKF, unsigned &globalIndexInc)
-    : KBlock::KBlock(_kfunction, block, km, instructionToRegisterMap,
-                     instructionsKF, globalIndexInc, KBlockType::Call),
+KCallBlock::KCallBlock(KFunction *_kfunction, llvm::BasicBlock *block,
+                       KInstruction **instructionsKF, unsigned &globalIndexInc)
+    : KBlock::KBlock(_kfunction, block, instructionsKF, globalIndexInc,
+                     KBlockType::Call),
       kcallInstruction(this->instructions[0]) {}
 
 bool KCallBlock::intrinsic() const {
@@ -756,33 +1063,31 @@ KFunction *KCallBlock::getKFunction() const {
 }
 
 KBasicBlock::KBasicBlock(KFunction *_kfunction, llvm::BasicBlock *block,
-                         KModule *km,
-                         const std::unordered_map<llvm::Instruction *, unsigned>
-                             &instructionToRegisterMap,
                          KInstruction **instructionsKF,
                          unsigned &globalIndexInc)
-    : KBlock::KBlock(_kfunction, block, km, instructionToRegisterMap,
-                     instructionsKF, globalIndexInc, KBlockType::Base) {}
+    : KBlock::KBlock(_kfunction, block, instructionsKF, globalIndexInc,
+                     KBlockType::Base) {}
 
-KReturnBlock::KReturnBlock(
-    KFunction *_kfunction, llvm::BasicBlock *block, KModule *km,
-    const std::unordered_map<Instruction *, unsigned> &instructionToRegisterMap,
-    KInstruction **instructionsKF, unsigned &globalIndexInc)
-    : KBlock::KBlock(_kfunction, block, km, instructionToRegisterMap,
-                     instructionsKF, globalIndexInc, KBlockType::Return) {}
+KReturnBlock::KReturnBlock(KFunction *_kfunction, llvm::BasicBlock *block,
+                           KInstruction **instructionsKF,
+                           unsigned &globalIndexInc)
+    : KBlock::KBlock(_kfunction, block, instructionsKF, globalIndexInc,
+                     KBlockType::Return) {}
 
 KBlockSet KBlock::successors() {
   KBlockSet result;
+  auto &blockMap = parent->getBlockMap();
   for (auto bb : llvm::successors(basicBlock())) {
-    result.insert(parent->blockMap[bb]);
+    result.insert(blockMap.at(bb));
   }
   return result;
 }
 
 KBlockSet KBlock::predecessors() {
   KBlockSet result;
+  auto &blockMap = parent->getBlockMap();
   for (auto bb : llvm::predecessors(basicBlock())) {
-    result.insert(parent->blockMap[bb]);
+    result.insert(blockMap.at(bb));
   }
   return result;
 }
@@ -799,10 +1104,12 @@ std::string KBlock::toString() const {
   return getLabel() + " in function " + parent->function()->getName().str();
 }
 
-uintptr_t KBlock::getId() const { return instructions - parent->instructions; }
+uintptr_t KBlock::getId() const {
+  return instructions - parent->getInstructions();
+}
 
 KInstruction *KFunction::getInstructionByRegister(size_t reg) const {
-  return instructions[reg - function()->arg_size()];
+  return getInstructions()[reg - function()->arg_size()];
 }
 
 bool KFunction::operator<(const KValue &rhs) const {
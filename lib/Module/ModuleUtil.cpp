@@ -227,6 +227,39 @@ static bool valueIsOnlyCalled(const Value *v) {
 
 bool klee::functionEscapes(const Function *f) { return !valueIsOnlyCalled(f); }
 
+static bool areCompatibleTypes(const Type *expected, const Type *actual) {
+  if (expected == actual)
+    return true;
+  if (expected->isPointerTy() && actual->isPointerTy())
+    return true;
+  if (expected->isIntegerTy() && actual->isIntegerTy())
+    return expected->getIntegerBitWidth() == actual->getIntegerBitWidth();
+  return false;
+}
+
+bool klee::isCompatibleIndirectCallTarget(const CallBase &cb,
+                                          const Function &f) {
+  const FunctionType *calleeType = f.getFunctionType();
+  unsigned numParams = calleeType->getNumParams();
+  unsigned numArgs = cb.arg_size();
+
+  if (numArgs < numParams)
+    return false;
+  if (numArgs > numParams && !calleeType->isVarArg() &&
+      !cb.getFunctionType()->isVarArg())
+    return false;
+
+  for (unsigned i = 0; i < numParams; ++i) {
+    if (!areCompatibleTypes(calleeType->getParamType(i),
+                            cb.getArgOperand(i)->getType()))
+      return false;
+  }
+
+  const Type *callType = cb.getType();
+  return callType->isVoidTy() ||
+         areCompatibleTypes(callType, calleeType->getReturnType());
+}
+
 bool klee::loadFile(const std::string &fileName, LLVMContext &context,
                     std::vector<std::unique_ptr<llvm::Module>> &modules,
                     std::string &errorMsg) {
@@ -272,4 +272,14 @@ void Optimize(Module *M, llvm::ArrayRef<const char *> preservedFunctions) {
   // Run our queue of passes all at once now, efficiently.
   Passes.run(*M);
 }
+
+/// DescribeOptimizeOptions - Print the values of all options that change
+/// the result of Optimize, e.g. to key a cache of optimised modules.
+void DescribeOptimizeOptions(raw_ostream &os) {
+  os << "disable-inlining=" << DisableInline
+     << " disable-internalize=" << DisableInternalize
+     << " strip-all=" << Strip << " strip-debug=" << StripDebug
+     << " delete-dead-loops=" << DeleteDeadLoops
+     << " optimize-aggressive=" << OptimizeAggressive << "\n";
+}
 } // namespace llvm
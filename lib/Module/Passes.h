@@ -57,9 +57,9 @@ public:
   bool runOnModule(llvm::Module &M) override;
 };
 
-// This is a module pass because it can add and delete module
-// variables (via intrinsic lowering).
-class IntrinsicCleanerPass : public llvm::ModulePass {
+// Intrinsic lowering can add function declarations to the module; the
+// llvm.trap declaration is removed once all functions have been cleaned.
+class IntrinsicCleanerPass : public llvm::FunctionPass {
   static char ID;
   const llvm::DataLayout &DataLayout;
   llvm::IntrinsicLowering *IL;
@@ -69,11 +69,12 @@ class IntrinsicCleanerPass : public llvm::ModulePass {
 
 public:
   IntrinsicCleanerPass(const llvm::DataLayout &TD, bool _WithFPRuntime)
-      : llvm::ModulePass(ID), DataLayout(TD),
+      : llvm::FunctionPass(ID), DataLayout(TD),
         IL(new llvm::IntrinsicLowering(TD)), WithFPRuntime(_WithFPRuntime) {}
   ~IntrinsicCleanerPass() { delete IL; }
 
-  bool runOnModule(llvm::Module &M) override;
+  bool runOnFunction(llvm::Function &F) override;
+  bool doFinalization(llvm::Module &M) override;
 };
 
 // performs two transformations which make interpretation
@@ -182,6 +183,9 @@ public:
   FunctionAliasPass() : llvm::ModulePass(ID) {}
   bool runOnModule(llvm::Module &M) override;
 
+  /// Print the requested aliases, which determine what this pass does.
+  static void describeOptions(llvm::raw_ostream &os);
+
 private:
   static const llvm::FunctionType *getFunctionType(const llvm::GlobalValue *gv);
   static bool checkType(const llvm::GlobalValue *match,
@@ -207,11 +211,12 @@ public:
 };
 
 /// Remove unwanted calls
-class CallRemover : public llvm::ModulePass {
+class CallRemover : public llvm::FunctionPass {
 public:
   static char ID;
-  CallRemover() : llvm::ModulePass(ID) {}
-  bool runOnModule(llvm::Module &M) override;
+  CallRemover() : llvm::FunctionPass(ID) {}
+  bool runOnFunction(llvm::Function &F) override;
+  bool doFinalization(llvm::Module &M) override;
 };
 
 class ReturnSplitter : public llvm::FunctionPass {
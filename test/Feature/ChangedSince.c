@@ -0,0 +1,33 @@
+// RUN: %clang %s -emit-llvm %O0opt -c -o %t1.bc -DDELTA=42
+// RUN: %clang %s -emit-llvm %O0opt -c -o %t2.bc -DDELTA=43
+// RUN: rm -rf %t.klee-out-1 %t.klee-out-2
+// RUN: %klee --output-dir=%t.klee-out-1 --write-function-hashes %t1.bc 2>&1 | FileCheck %s --check-prefix=CHECK-FIRST
+// RUN: FileCheck %s --check-prefix=CHECK-HASHES --input-file=%t.klee-out-1/function-hashes.txt
+// RUN: %klee --output-dir=%t.klee-out-2 --changed-since=%t.klee-out-1/function-hashes.txt --only-output-states-covering-new %t2.bc 2>&1 | FileCheck %s --check-prefix=CHECK-SECOND
+
+#include "klee/klee.h"
+
+static int square(int x) { return x * x; }
+static int offset(int x) { return x + DELTA; }
+
+int (*indirect)(int) = offset;
+
+int main() {
+  int a;
+  klee_make_symbolic(&a, sizeof(a), "a");
+  if (square(a) == 49)
+    return 1;
+  if (a == 3)
+    return indirect(a);
+  return 0;
+}
+
+// CHECK-FIRST: KLEE: done: generated tests = 3
+
+// CHECK-HASHES-DAG: {{[0-9a-f]+}} square
+// CHECK-HASHES-DAG: {{[0-9a-f]+}} offset
+// CHECK-HASHES-DAG: {{[0-9a-f]+}} main
+
+// Only the path through the changed function covers new code
+// CHECK-SECOND: KLEE: 1 of {{[0-9]+}} functions changed since
+// CHECK-SECOND: KLEE: done: generated tests = 1
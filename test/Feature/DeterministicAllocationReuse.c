@@ -0,0 +1,19 @@
+// RUN: %clang %s -emit-llvm %O0opt -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --allocate-determ --allocate-determ-size=1 --allocate-determ-quarantine=16 %t.bc 2>&1 | FileCheck %s
+
+// 4 MiB are allocated in total, but only a few objects are live at a time,
+// so recycled slots keep the run within 1 MiB of deterministic space.
+// CHECK-NOT: Not enough deterministic space left
+// CHECK: KLEE: done: completed paths = 1
+
+#include <stdlib.h>
+
+int main() {
+  for (int i = 0; i < 4096; ++i) {
+    char *p = malloc(1000);
+    p[0] = (char)i;
+    free(p);
+  }
+  return 0;
+}
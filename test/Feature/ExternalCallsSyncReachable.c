@@ -0,0 +1,24 @@
+// RUN: %clang %s -emit-llvm %O0opt -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --external-calls-sync-reachable %t.bc 2>&1 | FileCheck %s
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int main() {
+  char str[] = "123abc";
+  char *end = 0;
+  // Both the string and the object receiving the end pointer are reachable
+  // from the arguments
+  long value = strtol(str, &end, 10);
+  assert(value == 123 && end == str + 3);
+
+  char out[16];
+  sprintf(out, "%ld", value);
+  assert(out[0] == '1' && out[1] == '2' && out[2] == '3' && out[3] == 0);
+  return 0;
+}
+
+// CHECK-NOT: ASSERTION FAIL
+// CHECK: KLEE: done: completed paths = 1
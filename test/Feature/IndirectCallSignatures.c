@@ -0,0 +1,30 @@
+// RUN: %clang %s -emit-llvm %O0opt -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --search=nurs:md2u %t.bc 2>&1 | FileCheck %s
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --search=nurs:md2u --match-indirect-call-signatures=false %t.bc 2>&1 | FileCheck %s
+
+#include "klee/klee.h"
+
+static int twice(int x) { return 2 * x; }
+static long wide(long x) { return x + 1; }
+static void reset(int *p) { *p = 0; }
+
+int (*unary)(int) = twice;
+long (*widen)(long) = wide;
+void (*clear)(int *) = reset;
+
+int main() {
+  int a;
+  klee_make_symbolic(&a, sizeof(a), "a");
+  // Each call site only matches escaping functions of its own signature
+  if (unary(a) == 8)
+    return 1;
+  if (widen(a) == 10) {
+    clear(&a);
+    return a;
+  }
+  return 0;
+}
+
+// CHECK: KLEE: done: completed paths = 3
@@ -0,0 +1,29 @@
+// RUN: %clang %s -emit-llvm %O0opt -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --lazy-kfunctions %t.bc 2>&1 | FileCheck %s
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --lazy-kfunctions --search=nurs:md2u %t.bc 2>&1 | FileCheck %s
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --lazy-kfunctions=false %t.bc 2>&1 | FileCheck %s
+
+#include "klee/klee.h"
+
+static int square(int x) { return x * x; }
+static int offset(int x) { return x + 42; }
+static int never(int x) { return x - 7; }
+
+int (*indirect)(int) = offset;
+int (*unused)(int) = never;
+
+int main() {
+  int a;
+  klee_make_symbolic(&a, sizeof(a), "a");
+  if (square(a) == 49)
+    return 1;
+  // Functions reached only through pointers are built on their first call
+  if (a == 3)
+    return indirect(a);
+  return 0;
+}
+
+// CHECK: KLEE: done: completed paths = 3
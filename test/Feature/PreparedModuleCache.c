@@ -0,0 +1,25 @@
+// RUN: %clang %s -emit-llvm %O0opt -c -o %t.bc
+// RUN: rm -rf %t.klee-out %t.cache
+// RUN: %klee --output-dir=%t.klee-out --prepared-module-cache=%t.cache %t.bc 2>&1 | FileCheck -check-prefix=CHECK-STORE %s
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --prepared-module-cache=%t.cache %t.bc 2>&1 | FileCheck -check-prefix=CHECK-LOAD %s
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --prepared-module-cache=%t.cache --switch-type=simple %t.bc 2>&1 | FileCheck -check-prefix=CHECK-STORE %s
+
+// CHECK-STORE-NOT: Loaded prepared module
+// CHECK-STORE: KLEE: done: completed paths = 2
+// CHECK-LOAD: Loaded prepared module
+// CHECK-LOAD: KLEE: done: completed paths = 2
+
+#include "klee/klee.h"
+
+int main() {
+  int x;
+  klee_make_symbolic(&x, sizeof(x), "x");
+  switch (x) {
+  case 1:
+    return 1;
+  default:
+    return 0;
+  }
+}
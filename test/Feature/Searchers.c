@@ -18,6 +18,11 @@
 // RUN: rm -rf %t.klee-out
 // RUN: %klee --output-dir=%t.klee-out --search=random-path --search=nurs:qc %t2.bc
 // RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --search=random-path:states --search=random-path --search=random-path --search=random-path %t2.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --search=learned --learned-searcher-export-features %t2.bc
+// RUN: test -f %t.klee-out/searcher-features.csv
+// RUN: rm -rf %t.klee-out
 // RUN: %klee --output-dir=%t.klee-out --use-iterative-deepening-search=max-time --use-batching-search %t2.bc
 // RUN: rm -rf %t.klee-out
 // RUN: %klee --output-dir=%t.klee-out --use-iterative-deepening-search=max-time --use-batching-search --search=random-state %t2.bc
@@ -26,6 +31,8 @@
 // RUN: rm -rf %t.klee-out
 // RUN: %klee --output-dir=%t.klee-out --use-iterative-deepening-search=max-time --use-batching-search --search=nurs:qc %t2.bc
 // RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --use-batch-stepping --batch-states=3 --search=random-state %t2.bc
+// RUN: rm -rf %t.klee-out
 // RUN: %klee --output-dir=%t.klee-out --use-fair-search --entry-points=main --entry-points=other_main %t2.bc
 
 /* this test is basically just for coverage and doesn't really do any
@@ -0,0 +1,21 @@
+// RUN: %clang %s -emit-llvm %O0opt -g -c -o %t1.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --use-guided-search=none --search=dfs %t1.bc 2>&1 | FileCheck --check-prefix=CHECK-NOMERGE %s
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --use-guided-search=none --search=dfs --use-state-merging %t1.bc 2>&1 | FileCheck --check-prefix=CHECK-MERGE %s
+#include "klee/klee.h"
+
+int main() {
+  char input[4];
+  klee_make_symbolic(input, sizeof(input), "input");
+
+  int count = 0;
+  for (int i = 0; i < 4; ++i) {
+    if (input[i] > 'a')
+      count++;
+  }
+
+  // CHECK-NOMERGE: KLEE: done: completed paths = 16
+  // CHECK-MERGE: KLEE: done: completed paths = 1
+  return count;
+}
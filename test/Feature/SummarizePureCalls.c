@@ -0,0 +1,44 @@
+// RUN: %clang %s -emit-llvm %O0opt -c -o %t1.bc -DSUMMARIZE_PURE_CALLS_LIB
+// RUN: %llvmar r %t1.a %t1.bc
+//
+// RUN: %clang %s -emit-llvm %O0opt -c -o %t2.bc -DSUMMARIZE_PURE_CALLS_EXEC
+// RUN: rm -rf %t.klee-out-1 %t.klee-out-2
+// RUN: %klee --link-llvm-lib %t1.a --output-dir=%t.klee-out-1 --summarize-pure-calls %t2.bc 2>&1 | FileCheck %s
+// RUN: %klee-stats --print-columns 'SummarizedCalls' --table-format=csv %t.klee-out-1 | FileCheck %s --check-prefix=CHECK-SUMMARIZED
+// RUN: %klee --link-llvm-lib %t1.a --output-dir=%t.klee-out-2 --summarize-pure-calls=false %t2.bc 2>&1 | FileCheck %s
+// RUN: %klee-stats --print-columns 'SummarizedCalls' --table-format=csv %t.klee-out-2 | FileCheck %s --check-prefix=CHECK-EXECUTED
+
+#ifdef SUMMARIZE_PURE_CALLS_EXEC
+#include "klee/klee.h"
+
+#include <assert.h>
+
+__attribute__((const)) extern int cube(int x);
+
+int main() {
+  int sum = 0;
+  for (int i = 0; i < 100; ++i)
+    sum += cube(i % 4);
+  assert(sum == 25 * (0 + 1 + 8 + 27));
+
+  // Symbolic arguments are never summarized
+  int a;
+  klee_make_symbolic(&a, sizeof(a), "a");
+  if (cube(a) == 27)
+    return 1;
+  return 0;
+}
+#endif
+
+#ifdef SUMMARIZE_PURE_CALLS_LIB
+__attribute__((const)) int cube(int x) { return x * x * x; }
+#endif
+
+// CHECK-NOT: ASSERTION FAIL
+// CHECK: KLEE: done: completed paths = 2
+
+// Only the first call for each of the four concrete arguments is executed
+// CHECK-SUMMARIZED: SummarizedCalls
+// CHECK-SUMMARIZED-NEXT: {{^}}96{{$}}
+// CHECK-EXECUTED: SummarizedCalls
+// CHECK-EXECUTED-NEXT: {{^}}0{{$}}
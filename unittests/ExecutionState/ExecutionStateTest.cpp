@@ -0,0 +1,113 @@
+//===-- ExecutionStateTest.cpp --------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#define KLEE_UNITTEST
+#include "gtest/gtest.h"
+
+#include "Core/CoreStats.h"
+#include "Core/ExecutionState.h"
+#include "klee/Expr/Assignment.h"
+#include "klee/Expr/Expr.h"
+#include "klee/Expr/SourceBuilder.h"
+#include "klee/Module/KModule.h"
+
+#include "klee/Support/CompilerWarning.h"
+DISABLE_WARNING_PUSH
+DISABLE_WARNING_DEPRECATED_DECLARATIONS
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+DISABLE_WARNING_POP
+
+using namespace klee;
+
+namespace {
+
+ref<Expr> getSymbolicAddress(unsigned id) {
+  const Array *array = Array::create(ConstantExpr::create(8, Expr::Int64),
+                                     SourceBuilder::makeSymbolic("p", id));
+  return Expr::createTempRead(array, Expr::Int64);
+}
+
+TEST(ExecutionStateTest, ResolutionCache) {
+  ExecutionState es;
+  ref<Expr> p = getSymbolicAddress(0);
+  ref<Expr> q = getSymbolicAddress(1);
+
+  es.getResolutionCache().addNonNullBase(p);
+  es.getResolutionCache().addInBounds(p, nullptr, 4);
+  EXPECT_EQ(es.getResolutionCache().nonNullBases.count(p), 1u);
+  ASSERT_NE(es.getResolutionCache().inBounds.lookup(p), nullptr);
+  EXPECT_EQ(es.getResolutionCache().inBounds.lookup(p)->second, 4u);
+
+  // Forked states inherit the cache, but do not share later additions
+  ExecutionState forked(es);
+  EXPECT_EQ(forked.getResolutionCache().nonNullBases.count(p), 1u);
+  forked.getResolutionCache().addNonNullBase(q);
+  EXPECT_EQ(forked.getResolutionCache().nonNullBases.count(q), 1u);
+  EXPECT_EQ(es.getResolutionCache().nonNullBases.count(q), 0u);
+
+  // A new constraint epoch drops the cache
+  forked.constraints.rewriteConcretization(Assignment());
+  EXPECT_TRUE(forked.getResolutionCache().nonNullBases.empty());
+  EXPECT_TRUE(forked.getResolutionCache().inBounds.empty());
+  EXPECT_EQ(es.getResolutionCache().nonNullBases.count(p), 1u);
+
+  // A full cache is emptied before the next insertion
+  for (unsigned id = 2; id < 2000; ++id)
+    es.getResolutionCache().addNonNullBase(getSymbolicAddress(id));
+  EXPECT_LE(es.getResolutionCache().nonNullBases.size(), 1024u);
+  ref<Expr> last = getSymbolicAddress(1999);
+  EXPECT_EQ(es.getResolutionCache().nonNullBases.count(last), 1u);
+}
+
+TEST(ExecutionStateTest, CopyOnWriteFrames) {
+  // int f(int x) { return x; }
+  llvm::LLVMContext ctx;
+  llvm::Module module("m", ctx);
+  llvm::Type *i32 = llvm::Type::getInt32Ty(ctx);
+  llvm::Function *f = llvm::Function::Create(
+      llvm::FunctionType::get(i32, {i32}, false),
+      llvm::Function::ExternalLinkage, "f", module);
+  llvm::IRBuilder<> builder(llvm::BasicBlock::Create(ctx, "entry", f));
+  builder.CreateRet(f->getArg(0));
+  unsigned globalIndex = 0;
+  KFunction kf(f, nullptr, globalIndex);
+
+  ExecutionState es;
+  es.stack.pushFrame(KInstIterator(), &kf);
+  es.stack.pushFrame(KInstIterator(), &kf);
+  es.stack.valueStack().back().locals->set(0, Cell(1, Expr::Int32));
+
+  ExecutionState forked(es);
+  const ExecutionState &constForked = forked;
+  uint64_t copied = stats::copiedFrames;
+  // Reading does not unshare
+  EXPECT_EQ(constForked.stack.valueStack().back().locals->at(0).value(),
+            ConstantExpr::create(1, Expr::Int32));
+  EXPECT_EQ(&constForked.stack.valueStack().back(),
+            &std::as_const(es).stack.valueStack().back());
+  EXPECT_EQ(stats::copiedFrames, copied);
+
+  // Writing to the top frame clones only that frame
+  forked.stack.valueStack().back().locals->set(0, Cell(2, Expr::Int32));
+  EXPECT_EQ(stats::copiedFrames, copied + 1);
+  EXPECT_EQ(std::as_const(es).stack.valueStack().back().locals->at(0).value(),
+            ConstantExpr::create(1, Expr::Int32));
+  EXPECT_EQ(constForked.stack.valueStack().back().locals->at(0).value(),
+            ConstantExpr::create(2, Expr::Int32));
+  EXPECT_EQ(&constForked.stack.valueStack()[0],
+            &std::as_const(es).stack.valueStack()[0]);
+
+  // The frame is no longer shared, so writing again copies nothing
+  forked.stack.valueStack().back().locals->set(0, Cell(3, Expr::Int32));
+  es.stack.valueStack().back().locals->set(0, Cell(4, Expr::Int32));
+  EXPECT_EQ(stats::copiedFrames, copied + 1);
+}
+} // namespace
@@ -12,6 +12,7 @@
 
 #include "klee/Expr/ArrayCache.h"
 #include "klee/Expr/Expr.h"
+#include "klee/Expr/ExprUtil.h"
 #include "klee/Expr/SourceBuilder.h"
 
 using namespace klee;
@@ -288,4 +289,120 @@ TEST(ExprTest, ReadExprFoldingSymbolicIndexUpdate) {
     EXPECT_EQ(Expr::Read, read.get()->getKind());
   }
 }
+
+TEST(ExprTest, UpdateListCompaction) {
+  unsigned size = 64;
+
+  // Constant array
+  SparseStorageImpl<ref<ConstantExpr>> Contents(
+      ConstantExpr::create(0, Expr::Int8));
+  const Array *array =
+      Array::create(ConstantExpr::create(size, sizeof(uint64_t) * CHAR_BIT),
+                    SourceBuilder::constant(Contents.clone()));
+  const Array *array2 =
+      Array::create(ConstantExpr::create(256, sizeof(uint64_t) * CHAR_BIT),
+                    SourceBuilder::makeSymbolic("arr", 3));
+  ref<Expr> symbolicValue = ReadExpr::createTempRead(array2, Expr::Int8);
+
+  // Writes at constant indices, one of them overwritten by a symbolic value
+  UpdateList ul(array, 0);
+  for (unsigned i = 0; i < 32; ++i)
+    ul.extend(ConstantExpr::create(i, Expr::Int32),
+              ConstantExpr::create(i + 1, Expr::Int8));
+  ul.extend(ConstantExpr::create(3, Expr::Int32), symbolicValue);
+
+  // Reads outside of the written range skip the whole run
+  EXPECT_EQ(ul.head->getRunEnd(), nullptr);
+  EXPECT_FALSE(ul.head->runMayWrite(40));
+  ref<Expr> read = ReadExpr::create(ul, ConstantExpr::create(40, Expr::Int32));
+  EXPECT_EQ(Expr::Constant, read->getKind());
+
+  EXPECT_TRUE(ul.compact());
+  EXPECT_EQ(1u, ul.getSize());
+  EXPECT_EQ(symbolicValue,
+            ReadExpr::create(ul, ConstantExpr::create(3, Expr::Int32)));
+  read = ReadExpr::create(ul, ConstantExpr::create(7, Expr::Int32));
+  ASSERT_EQ(Expr::Constant, read->getKind());
+  EXPECT_EQ(8u, cast<ConstantExpr>(read)->getZExtValue());
+
+  // A write at a symbolic index prevents compaction
+  ul.extend(ReadExpr::createTempRead(array2, Expr::Int32),
+            ConstantExpr::create(1, Expr::Int8));
+  EXPECT_EQ(ul.head->getRunEnd(), ul.head.get());
+  EXPECT_FALSE(ul.compact());
+}
+
+TEST(ExprTest, ConstantInterning) {
+  // Small constants come from the preallocated table and are shared.
+  ref<ConstantExpr> minusOne = ConstantExpr::alloc(-1ULL, Expr::Int64);
+  EXPECT_EQ(minusOne.get(), ConstantExpr::getSmallConstant(-1ULL, Expr::Int64));
+  EXPECT_EQ(ConstantExpr::alloc(llvm::APInt(Expr::Int8, 200)).get(),
+            ConstantExpr::alloc(200, Expr::Int8).get());
+  EXPECT_EQ(ConstantExpr::getSmallConstant(1000, Expr::Int32), nullptr);
+  EXPECT_EQ(ConstantExpr::getSmallConstant(0, Expr::Int128), nullptr);
+
+  // Larger constants are interned while referenced and released afterwards.
+  std::size_t cached = ConstantExpr::getNumCachedConstants();
+  {
+    ref<ConstantExpr> a = ConstantExpr::alloc(123456789, Expr::Int32);
+    ref<ConstantExpr> b = ConstantExpr::alloc(123456789, Expr::Int32);
+    EXPECT_EQ(a.get(), b.get());
+    EXPECT_EQ(ConstantExpr::getNumCachedConstants(), cached + 1);
+  }
+  EXPECT_EQ(ConstantExpr::getNumCachedConstants(), cached);
+
+  // Both kinds are unique, so equals() compares them by identity: a float
+  // with the same bits is a different expression.
+  for (uint64_t bits : {1ULL, 0x3f800000ULL}) {
+    ref<ConstantExpr> i = ConstantExpr::alloc(bits, Expr::Int32);
+    ref<ConstantExpr> f =
+        ConstantExpr::alloc(llvm::APFloat(llvm::APFloat::IEEEsingle(),
+                                          llvm::APInt(Expr::Int32, bits)));
+    EXPECT_TRUE(i->equals(*ConstantExpr::alloc(bits, Expr::Int32)));
+    EXPECT_FALSE(i->equals(*f));
+  }
+}
+
+TEST(ExprTest, ValueBounds) {
+  const Array *array =
+      Array::create(ConstantExpr::create(256, sizeof(uint64_t) * CHAR_BIT),
+                    SourceBuilder::makeSymbolic("arr", 0));
+  ref<Expr> x = ZExtExpr::create(Expr::createTempRead(array, 8), 64);
+  ref<Expr> y = ZExtExpr::create(
+      ReadExpr::create(UpdateList(array, nullptr),
+                       ConstantExpr::create(1, Expr::Int32)),
+      64);
+  ref<Expr> c = Expr::createIsZero(x);
+  auto bounds = [](uint64_t min, uint64_t max) {
+    return std::make_pair(min, max);
+  };
+  auto full = bounds(0, UINT64_MAX);
+  ref<Expr> c100 = getConstant(100, 64);
+
+  EXPECT_EQ(getValueBounds(x), bounds(0, 255));
+  // sub that cannot wrap, and one that can
+  ref<Expr> x300 = AddExpr::create(x, getConstant(300, 64));
+  EXPECT_EQ(getValueBounds(SubExpr::create(x300, c100)), bounds(200, 455));
+  EXPECT_EQ(getValueBounds(SubExpr::create(x, c100)), full);
+  // urem and udiv by a range
+  EXPECT_EQ(getValueBounds(URemExpr::create(x, getConstant(10, 64))),
+            bounds(0, 9));
+  EXPECT_EQ(getValueBounds(
+                UDivExpr::create(x, AddExpr::create(y, getConstant(2, 64)))),
+            bounds(0, 127));
+  EXPECT_EQ(getValueBounds(UDivExpr::create(x, y)), full);
+  // select
+  EXPECT_EQ(getValueBounds(AddExpr::create(
+                SelectExpr::create(c, getConstant(16, 64), getConstant(32, 64)),
+                getConstant(4, 64))),
+            bounds(20, 36));
+
+  // Both branches of every select share the previous level: a tree walk
+  // would visit 2^64 nodes
+  ref<Expr> e = x;
+  for (int i = 0; i < 64; ++i)
+    e = SelectExpr::create(Expr::createIsZero(AddExpr::create(y, e)), e,
+                           AddExpr::create(e, getConstant(1, 64)));
+  EXPECT_EQ(getValueBounds(e), bounds(0, 255 + 64));
+}
 } // namespace
@@ -0,0 +1,109 @@
+//===-- MemoryTest.cpp ----------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "gtest/gtest.h"
+
+#include "Core/Memory.h"
+#include "klee/ADT/SparseStorage.h"
+#include "klee/Core/Context.h"
+#include "klee/Expr/Assignment.h"
+#include "klee/Expr/Expr.h"
+#include "klee/Expr/SourceBuilder.h"
+
+using namespace klee;
+
+namespace {
+
+class DenseObjectStageTest : public ::testing::Test {
+protected:
+  const Array *index;
+
+  static void SetUpTestSuite() { Context::initialize(true, Expr::Int64); }
+
+  void SetUp() override {
+    index = Array::create(ConstantExpr::create(1, Expr::Int64),
+                          SourceBuilder::makeSymbolic("index", 0));
+  }
+
+  ObjectStage makeStage(unsigned size) {
+    return ObjectStage(ConstantExpr::create(size, Expr::Int64), nullptr);
+  }
+
+  /// Reads `os` at the symbolic offset `index` and evaluates the read with
+  /// `index` bound to `offset`
+  uint64_t readAt(const ObjectStage &os, unsigned char offset,
+                  ref<Expr> *read = nullptr) {
+    ref<Expr> r = os.readWidth(Expr::createTempRead(index, Expr::Int8));
+    if (read)
+      *read = r;
+    SparseStorageImpl<unsigned char> value(0);
+    value.store(0, offset);
+    Assignment assignment({index}, {value});
+    return cast<ConstantExpr>(assignment.evaluate(r))->getZExtValue();
+  }
+};
+
+TEST_F(DenseObjectStageTest, ConcreteWrites) {
+  ObjectStage os = makeStage(16);
+  EXPECT_TRUE(os.isDenseConcrete());
+  EXPECT_TRUE(os.isKnownZero());
+
+  os.writeConcrete(4, 0x11223344, 4);
+  os.writeWidth(15, uint64_t(0xAB));
+  EXPECT_EQ(os.readConcrete(4, 4), 0x11223344u);
+  EXPECT_EQ(cast<ConstantExpr>(os.readWidth(15))->getZExtValue(), 0xABu);
+  EXPECT_EQ(cast<ConstantExpr>(os.readWidth(0))->getZExtValue(), 0u);
+  EXPECT_FALSE(os.isKnownZero());
+
+  // copies are independent
+  ObjectStage copy(os);
+  copy.writeConcrete(4, 0, 4);
+  EXPECT_EQ(os.readConcrete(4, 4), 0x11223344u);
+  EXPECT_TRUE(os.isDenseConcrete());
+  EXPECT_TRUE(copy.isDenseConcrete());
+
+  os.initializeToZero();
+  EXPECT_TRUE(os.isKnownZero());
+}
+
+TEST_F(DenseObjectStageTest, SymbolicWriteMakesSparse) {
+  ObjectStage os = makeStage(16);
+  os.writeConcrete(0, 0x0102, 2);
+  ref<Expr> symbolic = Expr::createTempRead(index, Expr::Int8);
+  os.writeWidth(8, symbolic);
+  EXPECT_FALSE(os.isDenseConcrete());
+  EXPECT_EQ(os.readWidth(8), symbolic);
+  EXPECT_EQ(cast<ConstantExpr>(os.readWidth(0))->getZExtValue(), 0x02u);
+  EXPECT_EQ(cast<ConstantExpr>(os.readWidth(1))->getZExtValue(), 0x01u);
+  EXPECT_EQ(cast<ConstantExpr>(os.readWidth(2))->getZExtValue(), 0u);
+}
+
+TEST_F(DenseObjectStageTest, SymbolicReadsAfterConcreteWrites) {
+  ObjectStage os = makeStage(16);
+  os.writeWidth(3, uint64_t(7));
+  EXPECT_EQ(readAt(os, 3), 7u);
+  // The first symbolic read leaves the dense representation
+  EXPECT_FALSE(os.isDenseConcrete());
+
+  // Later concrete writes extend the update list of the same array instead
+  // of building a new one for every read
+  ref<Expr> first, read;
+  readAt(os, 0, &first);
+  for (unsigned i = 0; i < 8; ++i) {
+    os.writeWidth(i, uint64_t(i + 100));
+    EXPECT_EQ(readAt(os, i, &read), i + 100);
+    EXPECT_EQ(cast<ReadExpr>(read)->updates.root,
+              cast<ReadExpr>(first)->updates.root);
+  }
+  EXPECT_EQ(readAt(os, 3), 103u);
+  EXPECT_EQ(readAt(os, 8), 0u);
+  EXPECT_EQ(cast<ConstantExpr>(os.readWidth(2))->getZExtValue(), 102u);
+  EXPECT_EQ(cast<ConstantExpr>(os.readWidth(9))->getZExtValue(), 0u);
+}
+} // namespace
@@ -0,0 +1,127 @@
+//===-- ModuleTest.cpp ----------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "gtest/gtest.h"
+
+#include "klee/Module/KModule.h"
+#include "klee/Support/ModuleUtil.h"
+
+#include "klee/Support/CompilerWarning.h"
+DISABLE_WARNING_PUSH
+DISABLE_WARNING_DEPRECATED_DECLARATIONS
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+DISABLE_WARNING_POP
+
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+
+// Candidate targets, and one indirect call site per case in @caller
+const char *const IndirectCallIR = R"IR(
+define i32 @int32(i32 %x) {
+  ret i32 %x
+}
+
+define i64 @int64(i64 %x) {
+  ret i64 %x
+}
+
+define i32 @pointer(i32* %p) {
+  ret i32 0
+}
+
+define i32 @variadic(i32 %x, ...) {
+  ret i32 %x
+}
+
+define void @caller(i32 (i32)* %f1, i64 (i64)* %f2, i32 (i8*)* %f3,
+                    i32 (i32, i32)* %f4, void (i32)* %f5, i16 (i32)* %f6) {
+  %same = call i32 %f1(i32 1)
+  %wide = call i64 %f2(i64 1)
+  %ptr = call i32 %f3(i8* null)
+  %extra = call i32 %f4(i32 1, i32 2)
+  call void %f5(i32 1)
+  %none = call i16 %f6(i32 1)
+  ret void
+}
+)IR";
+
+class IndirectCallTest : public ::testing::Test {
+protected:
+  llvm::LLVMContext ctx;
+  std::unique_ptr<llvm::Module> module;
+  std::vector<llvm::CallBase *> calls;
+
+  void SetUp() override {
+    llvm::SMDiagnostic err;
+    module = llvm::parseIR(
+        llvm::MemoryBufferRef(IndirectCallIR, "IndirectCallIR"), err, ctx);
+    ASSERT_TRUE(module) << err.getMessage().str();
+    for (auto &inst : llvm::instructions(module->getFunction("caller")))
+      if (auto cb = llvm::dyn_cast<llvm::CallBase>(&inst))
+        calls.push_back(cb);
+    ASSERT_EQ(calls.size(), 6u);
+  }
+
+  std::set<std::string> compatibleTargets(const llvm::CallBase &cb) {
+    std::set<std::string> names;
+    for (auto &f : *module)
+      if (f.getName() != "caller" && isCompatibleIndirectCallTarget(cb, f))
+        names.insert(f.getName().str());
+    return names;
+  }
+};
+
+TEST_F(IndirectCallTest, CompatibleTargets) {
+  using Names = std::set<std::string>;
+  // Variadic functions accept calls with exactly their fixed arguments
+  EXPECT_EQ(compatibleTargets(*calls[0]), (Names{"int32", "variadic"}));
+  // Integers only match integers of the same width
+  EXPECT_EQ(compatibleTargets(*calls[1]), (Names{"int64"}));
+  // Pointers match pointers of any pointee type
+  EXPECT_EQ(compatibleTargets(*calls[2]), (Names{"pointer"}));
+  // Surplus arguments need a variadic callee
+  EXPECT_EQ(compatibleTargets(*calls[3]), (Names{"variadic"}));
+  // A call that ignores the return value matches any return type
+  EXPECT_EQ(compatibleTargets(*calls[4]), (Names{"int32", "variadic"}));
+  // The return width has to match too
+  EXPECT_TRUE(compatibleTargets(*calls[5]).empty());
+}
+
+TEST_F(IndirectCallTest, FallbackToAllEscapingFunctions) {
+  KModule kmodule;
+  std::vector<std::unique_ptr<KFunction>> kfunctions;
+  unsigned globalIndex = 0;
+  for (const char *name : {"int32", "int64", "pointer", "variadic"}) {
+    kfunctions.push_back(std::make_unique<KFunction>(
+        module->getFunction(name), &kmodule, globalIndex));
+    kmodule.escapingFunctions.insert(kfunctions.back().get());
+  }
+
+  KFunctionSet targets;
+  kmodule.getIndirectCallTargets(*calls[1], targets);
+  EXPECT_EQ(targets, KFunctionSet{kfunctions[1].get()});
+
+  // No escaping function has a matching signature, so all are targets
+  targets.clear();
+  kmodule.getIndirectCallTargets(*calls[5], targets);
+  EXPECT_EQ(targets, kmodule.escapingFunctions);
+}
+} // namespace
@@ -11,6 +11,7 @@
 
 #include "gtest/gtest.h"
 
+#include "Core/CoreStats.h"
 #include "Core/ExecutionState.h"
 #include "Core/PForest.h"
 #include "Core/PTree.h"
@@ -20,9 +21,14 @@
 #include "klee/Support/CompilerWarning.h"
 DISABLE_WARNING_PUSH
 DISABLE_WARNING_DEPRECATED_DECLARATIONS
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/raw_ostream.h"
 DISABLE_WARNING_POP
 
+#include <cmath>
+#include <map>
+
 using namespace klee;
 
 namespace {
@@ -127,6 +133,84 @@ TEST(SearcherTest, TwoRandomPath) {
   processForest.remove(root.ptreeNode);
 }
 
+TEST(SearcherTest, RandomPathSubtreeSize) {
+  // Root state
+  ExecutionState root;
+  PForest processForest = PForest();
+  processForest.addRoot(&root);
+  root.ptreeNode = processForest.getPTrees()
+                       .at(root.ptreeNode->getTreeID())
+                       ->root.getPointer();
+  PTreeNode *rootPNode = root.ptreeNode;
+  PTreeNodePtr &rootPtr =
+      processForest.getPTrees().at(rootPNode->getTreeID())->root;
+
+  // root forks into es, es forks into es1 and es2
+  ExecutionState es(root);
+  processForest.attach(root.ptreeNode, &es, &root, BranchType::NONE);
+  ExecutionState es1(es);
+  processForest.attach(es.ptreeNode, &es1, &es, BranchType::NONE);
+  ExecutionState es2(es);
+  processForest.attach(es.ptreeNode, &es2, &es, BranchType::NONE);
+
+  RNG rng;
+  RandomPathSearcher rp(processForest, rng, RandomPathSearcher::SubtreeSize);
+  rp.update(nullptr, {&root, &es, &es1, &es2}, {});
+  // a second view that only owns es1 and root
+  RandomPathSearcher rp1(processForest, rng, RandomPathSearcher::SubtreeSize);
+  rp1.update(nullptr, {&es1, &root}, {});
+
+  EXPECT_EQ(rootPtr.getCount(0), 4u);
+  EXPECT_EQ(rootPNode->left.getCount(0), 3u);
+  EXPECT_EQ(rootPNode->right.getCount(0), 1u);
+  EXPECT_EQ(rootPtr.getCount(1), 2u);
+  EXPECT_EQ(rootPNode->left.getCount(1), 1u);
+  EXPECT_EQ(rootPNode->right.getCount(1), 1u);
+
+  // Every state should be picked roughly uniformly by each view
+  std::map<ExecutionState *, unsigned> picks, picks1;
+  for (int i = 0; i < 4000; i++) {
+    ++picks[&rp.selectState()];
+    ++picks1[&rp1.selectState()];
+  }
+  for (auto state : {&root, &es, &es1, &es2}) {
+    EXPECT_GT(picks[state], 800u);
+    EXPECT_LT(picks[state], 1200u);
+  }
+  for (auto state : {&root, &es1}) {
+    EXPECT_GT(picks1[state], 1800u);
+    EXPECT_LT(picks1[state], 2200u);
+  }
+
+  // a fork of an owned state inherits the counts of its node
+  ExecutionState es3(es1);
+  processForest.attach(es1.ptreeNode, &es3, &es1, BranchType::NONE);
+  rp.update(&es1, {&es3}, {});
+  EXPECT_EQ(rootPtr.getCount(0), 5u);
+  EXPECT_EQ(rootPtr.getCount(1), 2u);
+  EXPECT_EQ(es1.ptreeNode->parent->left.getCount(0), 1u);
+  EXPECT_EQ(es1.ptreeNode->parent->right.getCount(1), 1u);
+
+  rp.update(nullptr, {}, {&es2, &es3});
+  processForest.remove(es2.ptreeNode);
+  processForest.remove(es3.ptreeNode);
+  EXPECT_EQ(rootPtr.getCount(0), 3u);
+  EXPECT_EQ(rootPNode->left.getCount(0), 2u);
+
+  rp1.update(nullptr, {}, {&es1});
+  EXPECT_EQ(rootPtr.getCount(1), 1u);
+  EXPECT_FALSE(rootPNode->left.hasTag(1));
+  EXPECT_EQ(&rp1.selectState(), &root);
+
+  rp.update(nullptr, {}, {&root, &es, &es1});
+  rp1.update(nullptr, {}, {&root});
+  processForest.remove(es1.ptreeNode);
+  processForest.remove(es.ptreeNode);
+  processForest.remove(root.ptreeNode);
+  EXPECT_TRUE(rp.empty());
+  EXPECT_TRUE(rp1.empty());
+}
+
 TEST(SearcherTest, TwoRandomPathDot) {
   std::stringstream modelPTreeDot;
   PTreeNode *rootPNode, *rightLeafPNode, *esParentPNode, *es1LeafPNode,
@@ -170,13 +254,13 @@ TEST(SearcherTest, TwoRandomPathDot) {
       << "\tnode [style=\"filled\",width=.1,height=.1,fontname=\"Terminus\"]\n"
       << "\tedge [arrowsize=.3]\n"
       << "\tn" << rootPNode << " [shape=diamond];\n"
-      << "\tn" << rootPNode << " -> n" << esParentPNode << " [label=0b011];\n"
-      << "\tn" << rootPNode << " -> n" << rightLeafPNode << " [label=0b000];\n"
+      << "\tn" << rootPNode << " -> n" << esParentPNode << " [label=0b11];\n"
+      << "\tn" << rootPNode << " -> n" << rightLeafPNode << " [label=0b00];\n"
       << "\tn" << rightLeafPNode << " [shape=diamond,fillcolor=green];\n"
       << "\tn" << esParentPNode << " [shape=diamond];\n"
       << "\tn" << esParentPNode << " -> n" << es1LeafPNode
-      << " [label=0b010];\n"
-      << "\tn" << esParentPNode << " -> n" << esLeafPNode << " [label=0b001];\n"
+      << " [label=0b10];\n"
+      << "\tn" << esParentPNode << " -> n" << esLeafPNode << " [label=0b01];\n"
       << "\tn" << esLeafPNode << " [shape=diamond,fillcolor=green];\n"
       << "\tn" << es1LeafPNode << " [shape=diamond,fillcolor=green];\n"
       << "}\n";
@@ -201,12 +285,12 @@ TEST(SearcherTest, TwoRandomPathDot) {
       << "\tnode [style=\"filled\",width=.1,height=.1,fontname=\"Terminus\"]\n"
       << "\tedge [arrowsize=.3]\n"
       << "\tn" << rootPNode << " [shape=diamond];\n"
-      << "\tn" << rootPNode << " -> n" << esParentPNode << " [label=0b001];\n"
-      << "\tn" << rootPNode << " -> n" << rightLeafPNode << " [label=0b000];\n"
+      << "\tn" << rootPNode << " -> n" << esParentPNode << " [label=0b01];\n"
+      << "\tn" << rootPNode << " -> n" << rightLeafPNode << " [label=0b00];\n"
       << "\tn" << rightLeafPNode << " [shape=diamond,fillcolor=green];\n"
       << "\tn" << esParentPNode << " [shape=diamond];\n"
       << "\tn" << esParentPNode << " -> n" << es1LeafPNode
-      << " [label=0b001];\n"
+      << " [label=0b01];\n"
       << "\tn" << es1LeafPNode << " [shape=diamond,fillcolor=green];\n"
       << "}\n";
 
@@ -216,20 +300,191 @@ TEST(SearcherTest, TwoRandomPathDot) {
   processForest.remove(es1.ptreeNode);
   processForest.remove(root.ptreeNode);
 }
-TEST(SearcherDeathTest, TooManyRandomPaths) {
-  // First state
-  ExecutionState es;
+TEST(SearcherTest, ManyRandomPaths) {
+  // Root state
+  ExecutionState root;
   PForest processForest = PForest();
-  processForest.addRoot(&es);
-  es.ptreeNode = processForest.getPTrees()
-                     .at(es.ptreeNode->getTreeID())
-                     ->root.getPointer();
-  processForest.remove(es.ptreeNode); // Need to remove to avoid leaks
+  processForest.addRoot(&root);
+  root.ptreeNode = processForest.getPTrees()
+                       .at(root.ptreeNode->getTreeID())
+                       ->root.getPointer();
+
+  ExecutionState es(root);
+  processForest.attach(root.ptreeNode, &es, &root, BranchType::NONE);
 
   RNG rng;
-  RandomPathSearcher rp(processForest, rng);
-  RandomPathSearcher rp1(processForest, rng);
-  RandomPathSearcher rp2(processForest, rng);
-  ASSERT_DEATH({ RandomPathSearcher rp3(processForest, rng); }, "");
+  std::vector<std::unique_ptr<RandomPathSearcher>> searchers;
+  for (int i = 0; i < 80; i++)
+    searchers.emplace_back(new RandomPathSearcher(processForest, rng));
+
+  // Even searchers own the left state, odd ones the right state
+  for (size_t i = 0; i < searchers.size(); i++)
+    searchers[i]->update(nullptr, {i % 2 ? &root : &es}, {});
+
+  for (size_t i = 0; i < searchers.size(); i++) {
+    EXPECT_FALSE(searchers[i]->empty());
+    EXPECT_EQ(&searchers[i]->selectState(), i % 2 ? &root : &es);
+  }
+
+  for (size_t i = 0; i < searchers.size(); i++)
+    searchers[i]->update(nullptr, {}, {i % 2 ? &root : &es});
+
+  for (auto &searcher : searchers)
+    EXPECT_TRUE(searcher->empty());
+
+  processForest.remove(es.ptreeNode);
+  processForest.remove(root.ptreeNode);
+}
+
+TEST(SearcherTest, LearnedSearcher) {
+  ExecutionState es;
+  ExecutionState es1(es);
+  es1.depth = 20;
+
+  llvm::SmallString<128> modelPath;
+  int fd;
+  ASSERT_FALSE(
+      llvm::sys::fs::createTemporaryFile("model", "txt", fd, modelPath));
+  {
+    llvm::raw_fd_ostream model(fd, true);
+    model << "# prefer deep states\n"
+          << "forks 5\n"
+          << "md2u 0 # unused\n"
+          << "insts-since-cov-new 0\n";
+  }
+
+  RNG rng;
+  LearnedSearcher fixed(rng, 0.);
+  std::string error;
+  ASSERT_TRUE(fixed.loadModel(modelPath.str().str(), error)) << error;
+  EXPECT_EQ(fixed.getModel()[LearnedSearcher::Forks], 5.);
+  EXPECT_EQ(fixed.getModel()[LearnedSearcher::Bias], 0.);
+
+  fixed.update(nullptr, {&es, &es1}, {});
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(&fixed.selectState(), &es1);
+    fixed.update(&es1, {}, {});
+  }
+  EXPECT_EQ(fixed.getModel()[LearnedSearcher::Forks], 5.);
+
+  // Selecting es1 never covers anything, so its score is pulled down
+  LearnedSearcher online(rng, 0.01);
+  ASSERT_TRUE(online.loadModel(modelPath.str().str(), error)) << error;
+  online.update(nullptr, {&es1}, {});
+  EXPECT_EQ(&online.selectState(), &es1);
+  online.update(&es1, {}, {});
+  EXPECT_LT(online.getModel()[LearnedSearcher::Forks], 5.);
+  EXPECT_LT(online.getModel()[LearnedSearcher::Bias], 0.);
+  online.update(nullptr, {}, {&es1});
+  EXPECT_TRUE(online.empty());
+
+  {
+    std::error_code ec;
+    llvm::raw_fd_ostream model(modelPath, ec);
+    ASSERT_FALSE(ec);
+    model << "depth 1\n";
+  }
+  EXPECT_FALSE(fixed.loadModel(modelPath.str().str(), error));
+  EXPECT_NE(error.find("unknown feature 'depth'"), std::string::npos);
+  llvm::sys::fs::remove(modelPath);
+}
+
+TEST(SearcherTest, LearnedSearcherLargeFeatures) {
+  // |x|^2 of a long-running state is far above 2 / learningRate
+  ExecutionState es;
+  es.depth = 5000;
+  es.steppedInstructions = 2000000;
+  es.instsSinceCovNew = 1000000;
+  auto features = LearnedSearcher::getFeatures(es);
+  double norm = 0.;
+  for (auto feature : features)
+    norm += feature * feature;
+  EXPECT_GT(norm, 2. / 0.01);
+
+  RNG rng;
+  for (double rate : {0.01, 1.}) {
+    LearnedSearcher learned(rng, rate);
+    learned.update(nullptr, {&es}, {});
+    for (int i = 0; i < 1000; i++) {
+      EXPECT_EQ(&learned.selectState(), &es);
+      // reward every other selection
+      if (i % 2)
+        stats::coveredInstructions += 1000;
+      learned.update(&es, {}, {});
+    }
+    for (auto weight : learned.getModel()) {
+      EXPECT_TRUE(std::isfinite(weight));
+      EXPECT_LE(std::abs(weight), LearnedSearcher::MaxWeight);
+    }
+    learned.update(nullptr, {}, {&es});
+  }
+}
+
+// Random searcher that requires an update between two selections, as
+// searchers that learn from their last selection do
+class ExpectSelectUpdate final : public Searcher {
+  RandomSearcher random;
+  bool selected = false;
+
+public:
+  unsigned selections = 0;
+
+  explicit ExpectSelectUpdate(RNG &rng) : random(rng) {}
+
+  ExecutionState &selectState() override {
+    EXPECT_FALSE(selected) << "selected twice without an update";
+    selected = true;
+    ++selections;
+    return random.selectState();
+  }
+  void update(ExecutionState *current,
+              const std::vector<ExecutionState *> &addedStates,
+              const std::vector<ExecutionState *> &removedStates) override {
+    selected = false;
+    random.update(current, addedStates, removedStates);
+  }
+  bool empty() override { return random.empty(); }
+  void printName(llvm::raw_ostream &os) override {
+    os << "ExpectSelectUpdate\n";
+  }
+};
+
+TEST(SearcherTest, BatchStepping) {
+  ExecutionState es;
+  ExecutionState es1(es);
+  ExecutionState es2(es);
+
+  BatchSteppingSearcher bs(new DFSSearcher(), 4, 5);
+  EXPECT_TRUE(bs.empty());
+  bs.update(nullptr, {&es, &es1}, {});
+
+  // DFS keeps selecting the same state, so the batch is a single state
+  EXPECT_EQ(&bs.selectState(), &es1);
+  EXPECT_EQ(&bs.selectState(), &es1);
+
+  // a fork ends the slice
+  bs.update(&es1, {&es2}, {});
+  EXPECT_EQ(&bs.selectState(), &es2);
+
+  // terminated states leave the batch
+  bs.update(&es2, {}, {&es2});
+  EXPECT_EQ(&bs.selectState(), &es1);
+  bs.update(&es1, {}, {&es1});
+  EXPECT_EQ(&bs.selectState(), &es);
+
+  // an external call ends the slice, and the underlying searcher is asked
+  // for the next state only after the slice's updates
+  RNG rng;
+  ExpectSelectUpdate *alternating = new ExpectSelectUpdate(rng);
+  BatchSteppingSearcher rs(alternating, 8, 0);
+  rs.update(nullptr, {&es1, &es2}, {});
+  for (int i = 0; i < 100; i++) {
+    ExecutionState *first = &rs.selectState();
+    EXPECT_EQ(&rs.selectState(), first);
+    rs.update(first, {}, {});
+    ++stats::externalCalls;
+    rs.update(first, {}, {});
+  }
+  EXPECT_EQ(alternating->selections, 100u);
 }
 } // namespace